@@ -0,0 +1,148 @@
+#include "harness.hpp"
+
+#include "c3/nu/bit_ops.hpp"
+#include "c3/nu/bits.hpp"
+#include "c3/nu/rank_select.hpp"
+
+using namespace c3::nu;
+using namespace c3::nu::bench;
+
+// The bit at a time loops that get_datum and set_datum replaced, as a baseline
+template<n_bits_rep_t Bits>
+bit_datum<Bits> bitwise_get(bits_const_ref b, size_t pos) {
+  bit_datum<Bits> ret;
+  for (n_bits_rep_t i = 0; i < Bits; ++i)
+    if (b.get_bit(pos + i))
+      ret.set_bit(i);
+  return ret;
+}
+
+template<n_bits_rep_t Bits>
+void bitwise_set(bits_ref b, size_t pos, bit_datum<Bits> d) {
+  for (size_t i = 0; i < Bits; ++i)
+    if (d.get_bit(i))
+      b.set_bit(pos + i);
+}
+
+template<n_bits_rep_t Bits>
+void bench_width(runner& r, data& buf) {
+  const size_t n = buf.size() * CHAR_BIT / Bits;
+  const size_t bytes = n * Bits / CHAR_BIT;
+  const auto suffix = "/" + std::to_string(Bits);
+  using rep_t = typename bit_datum<Bits>::rep_t;
+
+  r.run("get_datum" + suffix, bytes, [&] {
+    bits_const_ref b{buf};
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+      acc += b.get_datum<Bits>(i * Bits).get();
+    do_not_optimise(acc);
+  });
+  r.run("get_datum_bitwise" + suffix, bytes, [&] {
+    bits_const_ref b{buf};
+    uint64_t acc = 0;
+    for (size_t i = 0; i < n; ++i)
+      acc += bitwise_get<Bits>(b, i * Bits).get();
+    do_not_optimise(acc);
+  });
+
+  r.run("set_datum" + suffix, bytes, [&] {
+    bits_ref b{buf};
+    for (size_t i = 0; i < n; ++i)
+      b.set_datum(i * Bits, bit_datum<Bits>{}.safe_set(static_cast<rep_t>(i)));
+    clobber(buf);
+  });
+  r.run("set_datum_bitwise" + suffix, bytes, [&] {
+    bits_ref b{buf};
+    for (size_t i = 0; i < n; ++i)
+      bitwise_set<Bits>(b, i * Bits, bit_datum<Bits>{}.safe_set(static_cast<rep_t>(i)));
+    clobber(buf);
+  });
+
+  std::vector<bit_datum<Bits>> split(bit_datum<Bits>::split_len(buf.size()));
+  r.run("split" + suffix, buf.size(), [&] {
+    bit_datum<Bits>::split(buf, split);
+    clobber(split);
+  });
+  r.run("combine" + suffix, buf.size(), [&] {
+    bit_datum<Bits>::combine(split, buf);
+    clobber(buf);
+  });
+}
+
+int main(int argc, char** argv) {
+  runner r{argc, argv};
+  xorshift rng;
+
+  data buf(4096);
+  for (auto& i : buf)
+    i = static_cast<uint8_t>(rng());
+
+  bench_width<1>(r, buf);
+  bench_width<4>(r, buf);
+  bench_width<5>(r, buf);
+  bench_width<6>(r, buf);
+  bench_width<7>(r, buf);
+  bench_width<8>(r, buf);
+  bench_width<12>(r, buf);
+  bench_width<24>(r, buf);
+  bench_width<32>(r, buf);
+  bench_width<63>(r, buf);
+
+  {
+    // A million bits, a quarter of them set
+    data bitmap(1 << 17);
+    for (auto& i : bitmap)
+      i = static_cast<uint8_t>(rng() & rng());
+    bits_const_ref bits{bitmap};
+
+    r.run("rank_select_bits/build_1m", bitmap.size(), [&] {
+      do_not_optimise(rank_select_bits{bits}.count_ones());
+    });
+
+    rank_select_bits rs{bits};
+    std::vector<size_t> queries(1024);
+    for (auto& i : queries)
+      i = rng() % rs.count_ones();
+
+    r.run("rank_select_bits/rank1_1m", 0, [&] {
+      size_t acc = 0;
+      for (auto i : queries)
+        acc += rs.rank1(i);
+      do_not_optimise(acc);
+    });
+    r.run("rank_select_bits/select1_1m", 0, [&] {
+      size_t acc = 0;
+      for (auto i : queries)
+        acc += rs.select1(i);
+      do_not_optimise(acc);
+    });
+    r.run("rank_select_bits/select0_1m", 0, [&] {
+      size_t acc = 0;
+      for (auto i : queries)
+        acc += rs.select0(i);
+      do_not_optimise(acc);
+    });
+
+    data other(bitmap.size());
+    for (auto& i : other)
+      i = static_cast<uint8_t>(rng());
+    r.run("bits_xor/aligned_1m", bitmap.size(), [&] {
+      bits_xor(bits_ref{other}, bits);
+      clobber(other);
+    });
+    r.run("bits_xor/unaligned_1m", bitmap.size(), [&] {
+      bits_xor(bits_ref{other}, 0, bits, 3, bits.BITS() - 3);
+      clobber(other);
+    });
+    r.run("count_set_bits/1m", bitmap.size(), [&] {
+      do_not_optimise(count_set_bits(bits));
+    });
+    r.run("set_bits/1m", bitmap.size(), [&] {
+      size_t acc = 0;
+      for (auto i : set_bits{bits})
+        acc += i;
+      do_not_optimise(acc);
+    });
+  }
+}
@@ -0,0 +1,98 @@
+#include "harness.hpp"
+
+#include "c3/nu/data/encoders/base64.hpp"
+#include "c3/nu/data/encoders/json.hpp"
+#include "c3/nu/data/encoders/xml.hpp"
+
+using namespace c3::nu;
+using namespace c3::nu::bench;
+
+int main(int argc, char** argv) {
+  runner r{argc, argv};
+  xorshift rng;
+
+  for (size_t len : {48, 4096, 1 << 18}) {
+    data b(len);
+    for (auto& i : b)
+      i = static_cast<uint8_t>(rng());
+    auto str = base64_encode_data(b);
+
+    r.run("base64_encode_data/" + std::to_string(len), len, [&] {
+      do_not_optimise(base64_encode_data(b));
+    });
+    r.run("base64_decode_data/" + std::to_string(len), len, [&] {
+      do_not_optimise(base64_decode_data(str));
+    });
+  }
+
+  {
+    // The fuzz corpus is mostly edge cases; the ones we accept make a realistic mix of small documents
+    std::vector<std::string> docs;
+    size_t total = 0;
+    for (auto& i : load_lines("testfiles/fuzz.json")) {
+      try { json_decode(i); }
+      catch (std::exception&) { continue; }
+      total += i.size();
+      docs.push_back(std::move(i));
+    }
+
+    r.run("json_decode/fuzz_corpus", total, [&] {
+      for (auto& i : docs)
+        do_not_optimise(json_decode(i));
+    });
+
+    std::vector<obj_struct> decoded;
+    for (auto& i : docs)
+      decoded.push_back(json_decode(i));
+    r.run("json_encode/fuzz_corpus", total, [&] {
+      for (auto& i : decoded)
+        do_not_optimise(json_encode(i));
+    });
+  }
+
+  {
+    obj_struct ds;
+    auto& arr = ds["records"].as<obj_struct::arr_t>();
+    for (size_t i = 0; i < 256; ++i) {
+      obj_struct rec;
+      rec["id"] = static_cast<int>(i);
+      rec["name"] = "record " + std::to_string(rng() % 100000);
+      rec["score"] = static_cast<double>(rng() % 1000) / 8;
+      rec["active"] = true;
+      rec["tags"].as<obj_struct::arr_t>() = { "alpha", "beta", "gamma" };
+      arr.push_back(std::move(rec));
+    }
+    auto str = json_encode(ds);
+
+    r.run("json_decode/records_256", str.size(), [&] {
+      do_not_optimise(json_decode(str));
+    });
+    r.run("json_encode/records_256", str.size(), [&] {
+      do_not_optimise(json_encode(ds));
+    });
+  }
+
+  {
+    markup_struct html("html");
+    auto& body = html.add_elem("body");
+    for (size_t i = 0; i < 256; ++i) {
+      body.add(
+        markup_struct{"div",
+          markup_struct::attr, "class", "row",
+          markup_struct::attr, "id", "row-" + std::to_string(i),
+          markup_struct{"h2", markup_struct::value, "Heading " + std::to_string(rng() % 100000)},
+          markup_struct::value, "Some text & some more",
+          markup_struct{"p", markup_struct::value, "A paragraph of text"}
+        }
+      );
+    }
+    auto str = xml_encode(html);
+
+    r.run("xml_decode/rows_256", str.size(), [&] {
+      do_not_optimise(xml_decode(str));
+    });
+    r.run("xml_encode/rows_256", str.size(), [&] {
+      do_not_optimise(xml_encode(html));
+    });
+  }
+}
@@ -0,0 +1,116 @@
+#include "harness.hpp"
+
+#include "c3/nu/data.hpp"
+#include "c3/nu/data/collections.hpp"
+
+using namespace c3::nu;
+using namespace c3::nu::bench;
+
+int main(int argc, char** argv) {
+  runner r{argc, argv};
+  xorshift rng;
+
+  {
+    uint64_t i = rng();
+    r.run("serialise/uint64", sizeof(i), [&] {
+      clobber(i);
+      do_not_optimise(serialise(i));
+    });
+
+    auto buf = serialise(i);
+    r.run("deserialise/uint64", sizeof(i), [&] {
+      clobber(buf);
+      do_not_optimise(deserialise<uint64_t>(buf));
+    });
+
+    r.run("deserialise/uint64/little", sizeof(i), [&] {
+      clobber(buf);
+      do_not_optimise(deserialise<uint64_t, byte_order::little>(buf));
+    });
+  }
+
+  {
+    std::string str(256, '\0');
+    for (auto& c : str)
+      c = static_cast<char>('a' + rng() % 26);
+
+    r.run("serialise/string_256", str.size(), [&] {
+      do_not_optimise(serialise(str));
+    });
+  }
+
+  {
+    std::string a = "the quick brown fox";
+    uint32_t b = 0x4a;
+    data c(64, 0x5a);
+    uint64_t d = rng();
+    std::string e = "jumps over the lazy dog";
+    auto len = squashed_size<uint16_t>(a, b, c, d, e);
+
+    r.run("squash/mixed_5", len, [&] {
+      do_not_optimise(squash<uint16_t>(a, b, c, d, e));
+    });
+    r.run("squash/mixed_5/varint", squashed_size<varint>(a, b, c, d, e), [&] {
+      do_not_optimise(squash<varint>(a, b, c, d, e));
+    });
+
+    auto buf = squash<uint16_t>(a, b, c, d, e);
+    r.run("expand/mixed_5", len, [&] {
+      std::string a_, e_;
+      uint32_t b_;
+      data c_;
+      uint64_t d_;
+      expand<uint16_t>(buf, a_, b_, c_, d_, e_);
+      do_not_optimise(e_);
+    });
+    r.run("expand/mixed_5/validate_once", len, [&] {
+      std::string a_, e_;
+      uint32_t b_;
+      data c_;
+      uint64_t d_;
+      expand<uint16_t, validation::validate_once>(buf, a_, b_, c_, d_, e_);
+      do_not_optimise(e_);
+    });
+  }
+
+  {
+    std::vector<uint32_t> ints(4096);
+    for (auto& i : ints)
+      i = static_cast<uint32_t>(rng());
+    auto buf = squash_seq(ints.begin(), ints.end());
+
+    r.run("squash_seq/uint32_4096", buf.size(), [&] {
+      do_not_optimise(squash_seq(ints.begin(), ints.end()));
+    });
+    r.run("expand_seq/uint32_4096", buf.size(), [&] {
+      do_not_optimise(expand_seq<uint32_t>(buf));
+    });
+    r.run("expand_seq/uint32_4096/little", buf.size(), [&] {
+      do_not_optimise(expand_seq<uint32_t, byte_order::little>(buf));
+    });
+  }
+
+  {
+    std::vector<std::string> strs(1024);
+    for (auto& i : strs) {
+      i.resize(4 + rng() % 28);
+      for (auto& c : i)
+        c = static_cast<char>('a' + rng() % 26);
+    }
+    auto buf = squash_seq<uint16_t>(strs.begin(), strs.end());
+    auto buf_varint = squash_seq<varint>(strs.begin(), strs.end());
+
+    r.run("squash_seq/string_1024", buf.size(), [&] {
+      do_not_optimise(squash_seq<uint16_t>(strs.begin(), strs.end()));
+    });
+    r.run("expand_seq/string_1024", buf.size(), [&] {
+      do_not_optimise(expand_seq<std::string, uint16_t>(buf));
+    });
+    r.run("expand_seq/string_1024/validate_once", buf.size(), [&] {
+      do_not_optimise(expand_seq<std::string, uint16_t, validation::validate_once>(buf));
+    });
+    r.run("expand_seq/string_1024/varint", buf_varint.size(), [&] {
+      do_not_optimise(expand_seq<std::string, varint>(buf_varint));
+    });
+  }
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A small timing harness for the benchmarks. Each benchmark is run in samples, each of which times a batch
+// of calls large enough to dwarf the clock's own cost, and one line of JSON is printed per benchmark:
+//
+//   {"name":"...","batch":...,"samples":...,"bytes":...,"ns_min":...,"ns_p50":...,"ns_p90":...,
+//    "ns_p99":...,"ns_mean":...,"bytes_per_sec":...}
+//
+// Timings are per call, and bytes is the payload of one call (0 when throughput means nothing).
+//
+// Every benchmark binary takes:
+//
+//   --samples N   timed samples per benchmark (default 100)
+//   --warmup N    untimed samples before them (default 10)
+//   --filter S    only run benchmarks whose names contain S
+
+namespace c3::nu::bench {
+  using clock = std::chrono::steady_clock;
+
+  /// Keeps the compiler from discarding a result that is otherwise unused
+  template<typename T>
+  inline void do_not_optimise(const T& t) {
+    asm volatile("" : : "r,m"(t) : "memory");
+  }
+
+  /// Keeps the compiler from assuming it knows what t holds
+  template<typename T>
+  inline void clobber(T& t) {
+    asm volatile("" : "+r,m"(t) : : "memory");
+  }
+
+  struct options {
+    size_t samples = 100;
+    size_t warmup = 10;
+    std::string filter;
+    /// A sample is batched until it takes at least this long
+    clock::duration min_sample = std::chrono::microseconds{200};
+  };
+
+  struct result {
+    std::string name;
+    size_t batch;
+    size_t samples;
+    size_t bytes;
+    double ns_min;
+    double ns_p50;
+    double ns_p90;
+    double ns_p99;
+    double ns_mean;
+
+    inline double bytes_per_sec() const { return ns_p50 > 0 ? bytes * 1e9 / ns_p50 : 0; }
+  };
+
+  inline void print(const result& r) {
+    std::string name;
+    for (auto c : r.name) {
+      if (c == '"' || c == '\\')
+        name.push_back('\\');
+      name.push_back(c);
+    }
+
+    std::printf("{\"name\":\"%s\",\"batch\":%zu,\"samples\":%zu,\"bytes\":%zu,"
+                "\"ns_min\":%.2f,\"ns_p50\":%.2f,\"ns_p90\":%.2f,\"ns_p99\":%.2f,\"ns_mean\":%.2f,"
+                "\"bytes_per_sec\":%.0f}\n",
+                name.c_str(), r.batch, r.samples, r.bytes,
+                r.ns_min, r.ns_p50, r.ns_p90, r.ns_p99, r.ns_mean, r.bytes_per_sec());
+    std::fflush(stdout);
+  }
+
+  class runner {
+  private:
+    options _opts;
+
+  private:
+    template<typename F>
+    inline static double _time_batch(F& f, size_t batch) {
+      auto start = clock::now();
+      for (size_t i = 0; i < batch; ++i)
+        f();
+      return std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    }
+
+    inline static double _percentile(const std::vector<double>& sorted, double p) {
+      auto idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+      return sorted[std::min(idx, sorted.size() - 1)];
+    }
+
+  public:
+    /// Times f, which should do one unit of work on bytes bytes of payload
+    template<typename F>
+    inline void run(std::string_view name, size_t bytes, F&& f) {
+      if (!_opts.filter.empty() && name.find(_opts.filter) == std::string_view::npos)
+        return;
+
+      // Double the batch until one sample is long enough to measure
+      auto min_ns = std::chrono::duration<double, std::nano>(_opts.min_sample).count();
+      size_t batch = 1;
+      while (_time_batch(f, batch) < min_ns && batch < (size_t{1} << 30))
+        batch *= 2;
+
+      for (size_t i = 0; i < _opts.warmup; ++i)
+        _time_batch(f, batch);
+
+      std::vector<double> samples(std::max<size_t>(_opts.samples, 1));
+      for (auto& i : samples)
+        i = _time_batch(f, batch) / batch;
+      std::sort(samples.begin(), samples.end());
+
+      double sum = 0;
+      for (auto i : samples)
+        sum += i;
+
+      print({
+        std::string{name}, batch, samples.size(), bytes,
+        samples.front(),
+        _percentile(samples, 0.5),
+        _percentile(samples, 0.9),
+        _percentile(samples, 0.99),
+        sum / samples.size()
+      });
+    }
+
+  public:
+    inline runner(options opts) : _opts{std::move(opts)} {}
+
+    inline runner(int argc, char** argv) {
+      for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (i + 1 == argc)
+          throw std::invalid_argument("Missing value for " + std::string{arg});
+        const char* val = argv[++i];
+
+        if (arg == "--samples")
+          _opts.samples = std::strtoull(val, nullptr, 10);
+        else if (arg == "--warmup")
+          _opts.warmup = std::strtoull(val, nullptr, 10);
+        else if (arg == "--filter")
+          _opts.filter = val;
+        else
+          throw std::invalid_argument("Unknown option " + std::string{arg});
+      }
+    }
+  };
+
+  /// Reads a whole file, relative to the build directory for the datasets under testfiles/
+  inline std::string load_file(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+      throw std::runtime_error("Could not open dataset " + path + " (run from the build directory)");
+    return {std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+  }
+
+  /// Reads a file as lines, skipping empty ones
+  inline std::vector<std::string> load_lines(const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs)
+      throw std::runtime_error("Could not open dataset " + path + " (run from the build directory)");
+
+    std::vector<std::string> ret;
+    std::string line;
+    while (std::getline(ifs, line))
+      if (!line.empty())
+        ret.push_back(std::move(line));
+    return ret;
+  }
+
+  /// Deterministic filler, so that runs are comparable
+  class xorshift {
+  private:
+    uint64_t _state;
+
+  public:
+    inline uint64_t operator()() {
+      _state ^= _state << 13;
+      _state ^= _state >> 7;
+      _state ^= _state << 17;
+      return _state;
+    }
+
+  public:
+    inline xorshift(uint64_t seed = 0x9e3779b97f4a7c15) : _state{seed} {}
+  };
+}
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "c3/nu/bits.hpp"
+
+// Whole-range operations over bits_ref and bits_const_ref, for bitmaps too large to walk a bit at a time.
+//
+// Ranges may start on any bit. Once the destination reaches a byte boundary, a source that lines up with it
+// is combined a vector at a time, and one that does not is shifted into line a word at a time.
+
+namespace c3::nu {
+  namespace _bit_ops {
+    struct and_op {
+      inline uint64_t operator()(uint64_t d, uint64_t s) const { return d & s; }
+#if defined(__SSE2__)
+      inline __m128i operator()(__m128i d, __m128i s) const { return _mm_and_si128(d, s); }
+#endif
+#if defined(__AVX2__)
+      inline __m256i operator()(__m256i d, __m256i s) const { return _mm256_and_si256(d, s); }
+#endif
+    };
+
+    struct or_op {
+      inline uint64_t operator()(uint64_t d, uint64_t s) const { return d | s; }
+#if defined(__SSE2__)
+      inline __m128i operator()(__m128i d, __m128i s) const { return _mm_or_si128(d, s); }
+#endif
+#if defined(__AVX2__)
+      inline __m256i operator()(__m256i d, __m256i s) const { return _mm256_or_si256(d, s); }
+#endif
+    };
+
+    struct xor_op {
+      inline uint64_t operator()(uint64_t d, uint64_t s) const { return d ^ s; }
+#if defined(__SSE2__)
+      inline __m128i operator()(__m128i d, __m128i s) const { return _mm_xor_si128(d, s); }
+#endif
+#if defined(__AVX2__)
+      inline __m256i operator()(__m256i d, __m256i s) const { return _mm256_xor_si256(d, s); }
+#endif
+    };
+
+    struct andnot_op {
+      inline uint64_t operator()(uint64_t d, uint64_t s) const { return d & ~s; }
+#if defined(__SSE2__)
+      inline __m128i operator()(__m128i d, __m128i s) const { return _mm_andnot_si128(s, d); }
+#endif
+#if defined(__AVX2__)
+      inline __m256i operator()(__m256i d, __m256i s) const { return _mm256_andnot_si256(s, d); }
+#endif
+    };
+
+    inline void check_range(bits_const_ref b, size_t pos, size_t n) {
+      if (pos > b.BITS() || n > b.BITS() - pos)
+        throw std::out_of_range("Bit range runs past the end");
+    }
+
+    template<typename Op>
+    inline void apply(bits_ref dst, size_t dst_pos, bits_const_ref src, size_t src_pos, size_t n, Op op) {
+      check_range(dst, dst_pos, n);
+      check_range(src, src_pos, n);
+
+      auto apply_field = [&](size_t len) {
+        auto d = _bit_access::read_field(dst.data(), dst.BITS(), dst_pos, len);
+        auto s = _bit_access::read_field(src.data(), src.BITS(), src_pos, len);
+        _bit_access::write_field(dst.data(), dst.BITS(), dst_pos, len, op(d, s));
+        dst_pos += len;
+        src_pos += len;
+        n -= len;
+      };
+
+      // Bring the destination up to a byte boundary
+      if (auto head = std::min<size_t>(n, (CHAR_BIT - dst_pos % CHAR_BIT) % CHAR_BIT); head != 0)
+        apply_field(head);
+
+      byte_t* d = dst.data() + dst_pos / CHAR_BIT;
+      size_t i = 0;
+
+      if (src_pos % CHAR_BIT == 0) {
+        // Lined up, so byte order does not matter
+        const byte_t* s = src.data() + src_pos / CHAR_BIT;
+        size_t n_bytes = n / CHAR_BIT;
+
+#if defined(__AVX2__)
+        for (; i + 32 <= n_bytes; i += 32) {
+          auto v = op(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(d + i)),
+                      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i), v);
+        }
+#endif
+#if defined(__SSE2__)
+        for (; i + 16 <= n_bytes; i += 16) {
+          auto v = op(_mm_loadu_si128(reinterpret_cast<const __m128i*>(d + i)),
+                      _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), v);
+        }
+#endif
+        for (; i + 8 <= n_bytes; i += 8) {
+          uint64_t dw, sw;
+          std::memcpy(&dw, d + i, sizeof(dw));
+          std::memcpy(&sw, s + i, sizeof(sw));
+          dw = op(dw, sw);
+          std::memcpy(d + i, &dw, sizeof(dw));
+        }
+      }
+      else {
+        // Each 64 bits of the source straddle 9 bytes, all of them inside the range
+        const byte_t* s = src.data() + src_pos / CHAR_BIT;
+        const auto shift = src_pos % CHAR_BIT;
+        for (; (i + 8) * CHAR_BIT <= n; i += 8) {
+          auto sw = (_bit_access::load_be64(s + i) << shift) | (s[i + 8] >> (CHAR_BIT - shift));
+          _bit_access::store_be64(d + i, op(_bit_access::load_be64(d + i), sw));
+        }
+      }
+
+      dst_pos += i * CHAR_BIT;
+      src_pos += i * CHAR_BIT;
+      n -= i * CHAR_BIT;
+      if (n != 0)
+        apply_field(n);
+    }
+  }
+
+  /// dst &= src, over the n bits from dst_pos and src_pos, which must not overlap unless they are the same
+  inline void bits_and(bits_ref dst, size_t dst_pos, bits_const_ref src, size_t src_pos, size_t n) {
+    _bit_ops::apply(dst, dst_pos, src, src_pos, n, _bit_ops::and_op{});
+  }
+  /// dst &= src, over all of dst
+  inline void bits_and(bits_ref dst, bits_const_ref src) { bits_and(dst, 0, src, 0, dst.BITS()); }
+
+  inline void bits_or(bits_ref dst, size_t dst_pos, bits_const_ref src, size_t src_pos, size_t n) {
+    _bit_ops::apply(dst, dst_pos, src, src_pos, n, _bit_ops::or_op{});
+  }
+  inline void bits_or(bits_ref dst, bits_const_ref src) { bits_or(dst, 0, src, 0, dst.BITS()); }
+
+  inline void bits_xor(bits_ref dst, size_t dst_pos, bits_const_ref src, size_t src_pos, size_t n) {
+    _bit_ops::apply(dst, dst_pos, src, src_pos, n, _bit_ops::xor_op{});
+  }
+  inline void bits_xor(bits_ref dst, bits_const_ref src) { bits_xor(dst, 0, src, 0, dst.BITS()); }
+
+  /// dst &= ~src, clearing every bit set in src
+  inline void bits_andnot(bits_ref dst, size_t dst_pos, bits_const_ref src, size_t src_pos, size_t n) {
+    _bit_ops::apply(dst, dst_pos, src, src_pos, n, _bit_ops::andnot_op{});
+  }
+  inline void bits_andnot(bits_ref dst, bits_const_ref src) { bits_andnot(dst, 0, src, 0, dst.BITS()); }
+
+  /// The set bits among the n from pos
+  inline size_t count_set_bits(bits_const_ref b, size_t pos, size_t n) {
+    _bit_ops::check_range(b, pos, n);
+
+    auto count_field = [&](size_t len) {
+      auto ret = static_cast<size_t>(__builtin_popcountll(_bit_access::read_field(b.data(), b.BITS(), pos, len)));
+      pos += len;
+      n -= len;
+      return ret;
+    };
+
+    size_t ret = 0;
+    if (auto head = std::min<size_t>(n, (CHAR_BIT - pos % CHAR_BIT) % CHAR_BIT); head != 0)
+      ret += count_field(head);
+
+    const byte_t* p = b.data() + pos / CHAR_BIT;
+    size_t n_bytes = n / CHAR_BIT;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    {
+      // Looks up each nibble's count, then sums each 8 bytes' worth
+      const auto lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+      const auto low = _mm256_set1_epi8(0x0f);
+      auto acc = _mm256_setzero_si256();
+      for (; i + 32 <= n_bytes; i += 32) {
+        auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        auto counts = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+                                      _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+      }
+      ret += static_cast<size_t>(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+                                 _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+    }
+#endif
+    for (; i + 8 <= n_bytes; i += 8) {
+      uint64_t w;
+      std::memcpy(&w, p + i, sizeof(w));
+      ret += static_cast<size_t>(__builtin_popcountll(w));
+    }
+
+    pos += i * CHAR_BIT;
+    n -= i * CHAR_BIT;
+    while (n != 0)
+      ret += count_field(std::min<size_t>(n, 64));
+    return ret;
+  }
+  inline size_t count_set_bits(bits_const_ref b) { return count_set_bits(b, 0, b.BITS()); }
+
+  /// The first set bit from pos on, or b.BITS() if there are none
+  inline size_t find_next_set(bits_const_ref b, size_t pos) noexcept {
+    const size_t len = b.BITS();
+    if (pos >= len)
+      return len;
+
+    const byte_t* p = b.data();
+    const size_t n_bytes = b.safe_access_bytes();
+    size_t byte = pos / CHAR_BIT;
+
+    // The last byte may hold bits past the end, which must not count
+    auto found = [&](size_t at) { return std::min(at, len); };
+
+    if (pos % CHAR_BIT != 0) {
+      auto rest = static_cast<byte_t>(p[byte] & (0xff >> (pos % CHAR_BIT)));
+      if (rest != 0)
+        return found(byte * CHAR_BIT + static_cast<size_t>(__builtin_clz(rest)) - (sizeof(unsigned) - 1) * CHAR_BIT);
+      ++byte;
+    }
+
+#if defined(__AVX2__)
+    for (; byte + 32 <= n_bytes; byte += 32) {
+      auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + byte));
+      if (!_mm256_testz_si256(v, v))
+        break;
+    }
+#endif
+    for (; byte + 8 <= n_bytes; byte += 8)
+      if (auto w = _bit_access::load_be64(p + byte); w != 0)
+        return found(byte * CHAR_BIT + static_cast<size_t>(__builtin_clzll(w)));
+    for (; byte < n_bytes; ++byte)
+      if (p[byte] != 0)
+        return found(byte * CHAR_BIT + static_cast<size_t>(__builtin_clz(p[byte])) - (sizeof(unsigned) - 1) * CHAR_BIT);
+
+    return len;
+  }
+  inline size_t find_first_set(bits_const_ref b) noexcept { return find_next_set(b, 0); }
+
+  /// The positions of the set bits in a bits_const_ref, in order
+  ///
+  /// Each 64 bits are loaded once and their set bits peeled off with lzcnt, and runs of unset bits are
+  /// skipped by find_next_set. As bits are numbered from the most significant end, the leading bit is
+  /// always the next one.
+  class set_bits {
+  private:
+    bits_const_ref _bits;
+
+  public:
+    class iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = size_t;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const size_t*;
+      using reference = size_t;
+
+    private:
+      bits_const_ref _bits;
+      /// The position of the first bit of _window
+      size_t _base;
+      /// The bits from _base, with those already visited cleared
+      uint64_t _window;
+      size_t _pos;
+
+    private:
+      inline void _seek(size_t pos) noexcept {
+        _pos = find_next_set(_bits, pos);
+        if (_pos == _bits.BITS())
+          return;
+        _base = _pos;
+        _window = _bit_access::read_field(_bits.data(), _bits.BITS(), _base, 64);
+      }
+
+    public:
+      inline size_t operator*() const noexcept { return _pos; }
+
+      inline iterator& operator++() noexcept {
+        _window ^= (uint64_t{1} << 63) >> (_pos - _base);
+        if (_window != 0)
+          _pos = _base + static_cast<size_t>(__builtin_clzll(_window));
+        else
+          _seek(_base + 64);
+        return *this;
+      }
+      inline iterator operator++(int) noexcept {
+        auto ret = *this;
+        ++*this;
+        return ret;
+      }
+
+      inline bool operator==(const iterator& other) const noexcept { return _pos == other._pos; }
+      inline bool operator!=(const iterator& other) const noexcept { return _pos != other._pos; }
+
+    public:
+      inline iterator(bits_const_ref bits, size_t pos) noexcept : _bits{bits}, _base{pos}, _window{0} {
+        _seek(pos);
+      }
+    };
+
+  public:
+    inline iterator begin() const noexcept { return { _bits, 0 }; }
+    inline iterator end() const noexcept { return { _bits, _bits.BITS() }; }
+
+  public:
+    inline set_bits(bits_const_ref bits) : _bits{bits} {}
+  };
+}
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
 
 #include <ostream>
 
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
 #include "c3/nu/data.hpp"
 #include "c3/nu/integer.hpp"
 
@@ -40,13 +46,15 @@ namespace c3::nu {
     constexpr size_t n_final_bits() const { return _bits % CHAR_BIT; }
 
   public:
+    constexpr const byte_t* data() const noexcept { return _ptr; }
+
     constexpr bool get_bit(size_t pos) const noexcept {
       return pos < _bits && (_ptr[pos / CHAR_BIT] & (1 << (CHAR_BIT - 1 - pos % CHAR_BIT))) != 0;
     }
     template<n_bits_rep_t Bits>
-    constexpr bit_datum<Bits> get_datum(size_t pos) const noexcept;
-    constexpr bit_datum<dynamic_size> get_datum(size_t pos, n_bits_rep_t bits) const noexcept;
-    constexpr uint8_t get_byte(size_t pos) const noexcept;
+    inline bit_datum<Bits> get_datum(size_t pos) const noexcept;
+    inline bit_datum<dynamic_size> get_datum(size_t pos, n_bits_rep_t bits) const noexcept;
+    inline uint8_t get_byte(size_t pos) const noexcept;
 
   public:
     constexpr bits_const_ref(decltype(_ptr) ptr, decltype(_bits) bits) :
@@ -69,6 +77,8 @@ namespace c3::nu {
     constexpr size_t n_final_bits() const { return _bits % CHAR_BIT; }
 
   public:
+    constexpr byte_t* data() const noexcept { return _ptr; }
+
     constexpr bool get_bit(size_t pos) const noexcept {
       return pos < _bits && (_ptr[pos / CHAR_BIT] & (1 << (CHAR_BIT - 1 - pos % CHAR_BIT))) != 0;
     }
@@ -76,16 +86,22 @@ namespace c3::nu {
       if (pos < _bits) (_ptr[pos / CHAR_BIT] |= (1 << (CHAR_BIT - 1 - pos % CHAR_BIT)));
     }
     constexpr void clear_bit(size_t pos) noexcept {
+      if (pos < _bits) (_ptr[pos / CHAR_BIT] &= static_cast<byte_t>(~(1 << (CHAR_BIT - 1 - pos % CHAR_BIT))));
+    }
+    constexpr void toggle_bit(size_t pos) noexcept {
       if (pos < _bits) (_ptr[pos / CHAR_BIT] ^= (1 << (CHAR_BIT - 1 - pos % CHAR_BIT)));
     }
     template<n_bits_rep_t Bits>
-    constexpr bit_datum<Bits> get_datum(size_t pos) const noexcept;
-    constexpr bit_datum<dynamic_size> get_datum(size_t pos, n_bits_rep_t bits) const noexcept;
+    inline bit_datum<Bits> get_datum(size_t pos) const noexcept;
+    inline bit_datum<dynamic_size> get_datum(size_t pos, n_bits_rep_t bits) const noexcept;
 
+    /// Overwrites the b.BITS() bits at pos with b, dropping any that fall past the end
     template<n_bits_rep_t Bits>
-    constexpr void set_datum(size_t pos, bit_datum<Bits> b) noexcept;
+    inline void set_datum(size_t pos, bit_datum<Bits> b) noexcept;
+
+    inline byte_t get_byte(size_t pos) const noexcept;
 
-    constexpr byte_t get_byte(size_t pos) const noexcept;
+    constexpr operator bits_const_ref() const noexcept { return { _ptr, _bits }; }
 
   public:
     constexpr bits_ref(decltype(_ptr) ptr, decltype(_bits) bits) :
@@ -94,6 +110,250 @@ namespace c3::nu {
       _ptr{b.data()}, _bits{static_cast<size_t>(b.size() * CHAR_BIT)} {}
   };
 
+  namespace _bit_access {
+    static_assert(CHAR_BIT == 8, "Word-at-a-time bit access assumes octets");
+
+    constexpr uint64_t low_mask(size_t n) {
+      return n >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t{1} << n) - 1;
+    }
+
+    inline uint64_t load_be64(const byte_t* p) {
+      uint64_t w;
+      std::memcpy(&w, p, sizeof(w));
+      return be64toh(w);
+    }
+
+    inline void store_be64(byte_t* p, uint64_t w) {
+      w = htobe64(w);
+      std::memcpy(p, &w, sizeof(w));
+    }
+
+    /// The up to 9 bytes at p as a big-endian window, zero filled past the avail that exist
+    ///
+    /// The first 8 go in hi, and the 9th in the top of lo
+    inline void load_tail(const byte_t* p, size_t avail, uint64_t& hi, uint64_t& lo) {
+      hi = lo = 0;
+      for (size_t i = 0; i < std::min<size_t>(avail, 8); ++i)
+        hi |= uint64_t{p[i]} << (56 - i * CHAR_BIT);
+      if (avail > 8)
+        lo = uint64_t{p[8]} << 56;
+    }
+
+    inline void store_tail(byte_t* p, size_t avail, uint64_t hi, uint64_t lo) {
+      for (size_t i = 0; i < std::min<size_t>(avail, 8); ++i)
+        p[i] = static_cast<byte_t>(hi >> (56 - i * CHAR_BIT));
+      if (avail > 8)
+        p[8] = static_cast<byte_t>(lo >> 56);
+    }
+
+    /// read_field for fields that straddle 9 bytes or run near the end of the buffer
+    inline uint64_t read_field_slow(const byte_t* p, size_t len, size_t pos, size_t n) {
+      if (n == 0 || pos >= len)
+        return 0;
+
+      size_t byte = pos / CHAR_BIT, shift = pos % CHAR_BIT;
+      uint64_t hi, lo;
+      load_tail(p + byte, divide_ceil<size_t>(len, CHAR_BIT) - byte, hi, lo);
+
+      // Only fields of more than 57 bits can reach lo, and only when shift is nonzero
+      uint64_t window = shift == 0 ? hi : (hi << shift) | (lo >> (64 - shift));
+      uint64_t ret = window >> (64 - n);
+      if (pos + n > len)
+        ret &= ~low_mask(pos + n - len);
+      return ret;
+    }
+
+    /// Reads the n <= 64 bits at pos in a buffer of len bits, where any past the end read as 0
+    inline uint64_t read_field(const byte_t* p, size_t len, size_t pos, size_t n) {
+      size_t byte = pos / CHAR_BIT, shift = pos % CHAR_BIT;
+      if (n != 0 && shift + n <= 64 && pos + n <= len && byte + 8 <= divide_ceil<size_t>(len, CHAR_BIT))
+        return (load_be64(p + byte) << shift) >> (64 - n);
+      return read_field_slow(p, len, pos, n);
+    }
+
+    inline void write_field_slow(byte_t* p, size_t len, size_t pos, size_t n, uint64_t value) {
+      if (n == 0 || pos >= len)
+        return;
+
+      // Left align the field, then drop anything past the end
+      uint64_t mask = low_mask(n) << (64 - n);
+      if (pos + n > len)
+        mask &= ~(low_mask(pos + n - len) << (64 - n));
+      value = (value << (64 - n)) & mask;
+
+      size_t byte = pos / CHAR_BIT, shift = pos % CHAR_BIT;
+      size_t avail = divide_ceil<size_t>(len, CHAR_BIT) - byte;
+      uint64_t hi, lo;
+      load_tail(p + byte, avail, hi, lo);
+
+      hi = (hi & ~(mask >> shift)) | (value >> shift);
+      if (shift != 0)
+        lo = (lo & ~(mask << (64 - shift))) | (value << (64 - shift));
+
+      store_tail(p + byte, avail, hi, lo);
+    }
+
+    /// Overwrites the n <= 64 bits at pos in a buffer of len bits with the low n bits of value,
+    /// leaving alone any that fall past the end
+    inline void write_field(byte_t* p, size_t len, size_t pos, size_t n, uint64_t value) {
+      size_t byte = pos / CHAR_BIT, shift = pos % CHAR_BIT;
+      if (n != 0 && shift + n <= 64 && pos + n <= len && byte + 8 <= divide_ceil<size_t>(len, CHAR_BIT)) {
+        size_t field_shift = 64 - shift - n;
+        uint64_t mask = low_mask(n) << field_shift;
+        uint64_t w = load_be64(p + byte);
+        store_be64(p + byte, (w & ~mask) | ((value << field_shift) & mask));
+        return;
+      }
+      write_field_slow(p, len, pos, n, value);
+    }
+  }
+
+  /// Reads consecutive fields from a bits_const_ref, refilling a 64-bit window a word at a time
+  ///
+  /// As with get_datum, anything past the end reads as 0, so check remaining() where that matters
+  class bit_reader {
+  private:
+    bits_const_ref _bits;
+    /// The position of the first bit in _window
+    size_t _pos;
+    /// The next bits from _pos, most significant first
+    uint64_t _window = 0;
+    size_t _avail = 0;
+
+  private:
+    inline void _refill() {
+      size_t byte = _pos / CHAR_BIT, shift = _pos % CHAR_BIT;
+      _avail = 64 - shift;
+
+      if (byte + 8 <= _bits.n_full_bytes()) {
+        _window = _bit_access::load_be64(_bits.data() + byte) << shift;
+        return;
+      }
+
+      uint64_t hi, lo;
+      size_t n_bytes = _bits.safe_access_bytes();
+      _bit_access::load_tail(_bits.data() + byte, byte < n_bytes ? n_bytes - byte : 0, hi, lo);
+      _window = hi << shift;
+      if (_pos >= _bits.BITS())
+        _window = 0;
+      else if (_bits.BITS() - _pos < 64)
+        _window &= ~_bit_access::low_mask(64 - (_bits.BITS() - _pos));
+    }
+
+  public:
+    inline size_t position() const noexcept { return _pos; }
+    inline size_t remaining() const noexcept { return _pos < _bits.BITS() ? _bits.BITS() - _pos : 0; }
+
+    /// The next n <= 64 bits, without consuming them
+    inline uint64_t peek(n_bits_rep_t n) noexcept {
+      if (n == 0)
+        return 0;
+      if (n > _avail)
+        _refill();
+      if (n <= _avail)
+        return _window >> (64 - n);
+
+      // A refilled window always has at least 57 bits, so only wider fields get here
+      size_t rest = n - _avail;
+      return ((_window >> (64 - _avail)) << rest) |
+             _bit_access::read_field(_bits.data(), _bits.BITS(), _pos + _avail, rest);
+    }
+
+    inline void skip(size_t n) noexcept {
+      if (n < _avail) {
+        _window <<= n;
+        _avail -= n;
+      }
+      else
+        _avail = 0;
+      _pos += n;
+    }
+
+    inline uint64_t read(n_bits_rep_t n) noexcept {
+      auto ret = peek(n);
+      skip(n);
+      return ret;
+    }
+
+    template<n_bits_rep_t Bits>
+    inline bit_datum<Bits> read() noexcept {
+      return static_cast<typename bit_datum<Bits>::rep_t>(read(Bits));
+    }
+
+  public:
+    inline bit_reader(bits_const_ref bits, size_t pos = 0) : _bits{bits}, _pos{pos} {}
+  };
+
+  /// Writes consecutive fields to a bits_ref, a word at a time
+  ///
+  /// Fields overwrite whatever was there, and anything past the end is dropped, as with set_datum. Bits are
+  /// held back until a whole word is ready, so the buffer is only up to date after flush(), which the
+  /// destructor also calls.
+  class bit_writer {
+  private:
+    bits_ref _bits;
+    /// Where the first bit of _acc goes, which is always on a byte boundary
+    size_t _byte;
+    /// Pending bits, least significant last
+    uint64_t _acc = 0;
+    size_t _acc_bits = 0;
+
+  private:
+    /// Writes out every whole byte in _acc
+    inline void _drain() noexcept {
+      size_t n_bytes = _acc_bits / CHAR_BIT;
+      if (n_bytes == 0)
+        return;
+
+      size_t rest = _acc_bits % CHAR_BIT;
+      _bit_access::write_field(_bits.data(), _bits.BITS(), _byte * CHAR_BIT, n_bytes * CHAR_BIT, _acc >> rest);
+      _byte += n_bytes;
+      _acc &= _bit_access::low_mask(rest);
+      _acc_bits = rest;
+    }
+
+  public:
+    inline size_t position() const noexcept { return _byte * CHAR_BIT + _acc_bits; }
+
+    /// Writes the low n <= 64 bits of value
+    inline void write(n_bits_rep_t n, uint64_t value) noexcept {
+      // Keep room for the up to 7 bits that _drain leaves behind
+      if (n > 56) {
+        write(static_cast<n_bits_rep_t>(n - 32), value >> 32);
+        write(32, value);
+        return;
+      }
+
+      if (_acc_bits + n > 64)
+        _drain();
+      _acc = (_acc << n) | (value & _bit_access::low_mask(n));
+      _acc_bits += n;
+    }
+
+    template<n_bits_rep_t Bits>
+    inline void write(bit_datum<Bits> value) noexcept {
+      write(Bits, value.get());
+    }
+
+    /// Writes out everything so far, merging any final partial byte with what is already there
+    inline void flush() noexcept {
+      _drain();
+      _bit_access::write_field(_bits.data(), _bits.BITS(), _byte * CHAR_BIT, _acc_bits, _acc);
+    }
+
+  public:
+    inline bit_writer(bits_ref bits, size_t pos = 0) : _bits{bits}, _byte{pos / CHAR_BIT} {
+      // Start from the byte boundary, keeping the bits before pos as they are
+      _acc_bits = pos % CHAR_BIT;
+      _acc = _bit_access::read_field(_bits.data(), _bits.BITS(), _byte * CHAR_BIT, _acc_bits);
+    }
+
+    bit_writer(const bit_writer&) = delete;
+    bit_writer& operator=(const bit_writer&) = delete;
+
+    inline ~bit_writer() { flush(); }
+  };
+
   template<n_bits_rep_t Bits, typename = Range<true>>
   class bit_datum_rep;
 
@@ -101,30 +361,226 @@ namespace c3::nu {
   class bit_datum_rep<Bits, Range<(Bits >= 1 && Bits <= 8)>> {
   public:
     using type = uint8_t;
-    static constexpr type Mask = std::numeric_limits<type>::max() >> (CHAR_BIT - 1 - Bits);
+    static constexpr type Mask = std::numeric_limits<type>::max() >> (std::numeric_limits<type>::digits - Bits);
   };
 
   template<n_bits_rep_t Bits>
   class bit_datum_rep<Bits, Range<(Bits > 8 && Bits <= 16)>> {
   public:
     using type = uint16_t;
-    static constexpr type Mask = std::numeric_limits<type>::max() >> (15 - Bits);
+    static constexpr type Mask = std::numeric_limits<type>::max() >> (std::numeric_limits<type>::digits - Bits);
   };
 
   template<n_bits_rep_t Bits>
   class bit_datum_rep<Bits, Range<(Bits > 16 && Bits <= 32)>> {
   public:
     using type = uint32_t;
-    static constexpr type Mask = std::numeric_limits<type>::max() >> (31 - Bits);
+    static constexpr type Mask = std::numeric_limits<type>::max() >> (std::numeric_limits<type>::digits - Bits);
   };
 
   template<n_bits_rep_t Bits>
   class bit_datum_rep<Bits, Range<(Bits > 32 && Bits <= 64)>> {
   public:
     using type = uint64_t;
-    static constexpr type Mask = std::numeric_limits<type>::max() >> (63 - Bits);
+    static constexpr type Mask = std::numeric_limits<type>::max() >> (std::numeric_limits<type>::digits - Bits);
   };
 
+  namespace _bit_simd {
+    /// Split and combine kernels for whole blocks of Bits bit data, which return how many data they handled
+    /// so that the caller can finish off the rest
+    ///
+    /// This is the fallback, which handles none
+    template<n_bits_rep_t Bits, typename = Range<true>>
+    struct kernel {
+      static inline size_t split(const byte_t*, size_t, byte_t*, size_t) { return 0; }
+      static inline size_t combine(const byte_t*, size_t, byte_t*, size_t) { return 0; }
+    };
+
+#if defined(__SSSE3__)
+    /// pshufb masks putting the 2 bytes that hold each of 8 Bits bit fields into a big-endian 16-bit lane,
+    /// for the 8 fields from byte 0 and the 8 from byte Bits, and the multipliers that then shift each
+    /// field to the top of its lane
+    template<n_bits_rep_t Bits>
+    struct split_masks {
+      alignas(16) uint8_t shuffle[2][16];
+      alignas(16) uint16_t shift[8];
+
+      constexpr split_masks() : shuffle{}, shift{} {
+        for (size_t group = 0; group < 2; ++group) {
+          for (size_t i = 0; i < 8; ++i) {
+            auto byte = group * Bits + i * Bits / CHAR_BIT;
+            shuffle[group][2 * i] = static_cast<uint8_t>(byte + 1);
+            shuffle[group][2 * i + 1] = static_cast<uint8_t>(byte);
+          }
+        }
+        for (size_t i = 0; i < 8; ++i)
+          shift[i] = static_cast<uint16_t>(1 << (i * Bits % CHAR_BIT));
+      }
+    };
+    template<n_bits_rep_t Bits>
+    inline constexpr split_masks<Bits> split_mask{};
+
+    /// A pshufb mask taking the low Width bytes of each of Lanes lanes, most significant first, and
+    /// packing them together at the bottom
+    template<size_t Width, size_t Lanes>
+    struct gather_masks {
+      alignas(16) uint8_t shuffle[16];
+
+      constexpr gather_masks() : shuffle{} {
+        for (size_t i = 0; i < 16; ++i)
+          shuffle[i] = i < Width * Lanes ? static_cast<uint8_t>(i / Width * (16 / Lanes) + Width - 1 - i % Width)
+                                         : 0x80;
+      }
+    };
+    template<size_t Width, size_t Lanes>
+    inline constexpr gather_masks<Width, Lanes> gather_mask{};
+
+    inline __m128i load(const void* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    inline void store(byte_t* p, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+#if defined(__AVX2__)
+    inline __m256i load(const void* lo, const void* hi) {
+      return _mm256_inserti128_si256(_mm256_castsi128_si256(load(lo)), load(hi), 1);
+    }
+    inline __m256i broadcast(const void* p) { return _mm256_broadcastsi128_si256(load(p)); }
+#endif
+
+    /// Data of 4 to 7 bits, each of which fits in the 2 bytes from its first
+    template<n_bits_rep_t Bits>
+    struct kernel<Bits, Range<(Bits >= 4 && Bits <= 7)>> {
+      /// Splits 16 data out of each 2 * Bits bytes
+      static inline size_t split(const byte_t* in, size_t in_len, byte_t* out, size_t n_out) {
+        const auto& m = split_mask<Bits>;
+        size_t done = 0;
+
+#if defined(__AVX2__)
+        const auto shuffle_a_256 = broadcast(m.shuffle[0]);
+        const auto shuffle_b_256 = broadcast(m.shuffle[1]);
+        const auto shift_256 = broadcast(m.shift);
+        for (; done + 32 <= n_out && done * Bits / 8 + 2 * Bits + 16 <= in_len; done += 32) {
+          const byte_t* p = in + done * Bits / 8;
+          auto v = load(p, p + 2 * Bits);
+          auto a = _mm256_mullo_epi16(_mm256_shuffle_epi8(v, shuffle_a_256), shift_256);
+          auto b = _mm256_mullo_epi16(_mm256_shuffle_epi8(v, shuffle_b_256), shift_256);
+          v = _mm256_packus_epi16(_mm256_srli_epi16(a, 16 - Bits), _mm256_srli_epi16(b, 16 - Bits));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done), v);
+        }
+#endif
+
+        const auto shuffle_a = load(m.shuffle[0]);
+        const auto shuffle_b = load(m.shuffle[1]);
+        const auto shift = load(m.shift);
+        for (; done + 16 <= n_out && done * Bits / 8 + 16 <= in_len; done += 16) {
+          auto v = load(in + done * Bits / 8);
+          auto a = _mm_mullo_epi16(_mm_shuffle_epi8(v, shuffle_a), shift);
+          auto b = _mm_mullo_epi16(_mm_shuffle_epi8(v, shuffle_b), shift);
+          store(out + done, _mm_packus_epi16(_mm_srli_epi16(a, 16 - Bits), _mm_srli_epi16(b, 16 - Bits)));
+        }
+
+        return done;
+      }
+
+      /// Merges pairs of data, then pairs of those, until each 64-bit lane holds 8 of them
+      static inline __m128i merge(__m128i v) {
+        v = _mm_and_si128(v, _mm_set1_epi8((1 << Bits) - 1));
+        v = _mm_maddubs_epi16(_mm_set1_epi16((1 << 8) | (1 << Bits)), v);
+        v = _mm_madd_epi16(v, _mm_set1_epi32((1 << 16) | (1 << (2 * Bits))));
+        return _mm_or_si128(_mm_slli_epi64(_mm_and_si128(v, _mm_set1_epi64x(0xffffffff)), 4 * Bits),
+                            _mm_srli_epi64(v, 32));
+      }
+#if defined(__AVX2__)
+      static inline __m256i merge(__m256i v) {
+        v = _mm256_and_si256(v, _mm256_set1_epi8((1 << Bits) - 1));
+        v = _mm256_maddubs_epi16(_mm256_set1_epi16((1 << 8) | (1 << Bits)), v);
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32((1 << 16) | (1 << (2 * Bits))));
+        return _mm256_or_si256(_mm256_slli_epi64(_mm256_and_si256(v, _mm256_set1_epi64x(0xffffffff)), 4 * Bits),
+                               _mm256_srli_epi64(v, 32));
+      }
+#endif
+
+      /// Combines each 16 data into 2 * Bits bytes
+      ///
+      /// Every store is a full 16 bytes, so this stops where the data run out of bytes to overwrite
+      static inline size_t combine(const byte_t* in, size_t n_in, byte_t* out, size_t out_len) {
+        const size_t out_limit = std::min(out_len, n_in * Bits / CHAR_BIT);
+        const auto& gather = gather_mask<Bits, 2>.shuffle;
+        size_t done = 0;
+
+#if defined(__AVX2__)
+        const auto gather_256 = broadcast(gather);
+        for (; done + 32 <= n_in && done * Bits / 8 + 2 * Bits + 16 <= out_limit; done += 32) {
+          auto v = _mm256_shuffle_epi8(merge(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + done))),
+                                       gather_256);
+          byte_t* p = out + done * Bits / 8;
+          store(p, _mm256_castsi256_si128(v));
+          store(p + 2 * Bits, _mm256_extracti128_si256(v, 1));
+        }
+#endif
+
+        for (; done + 16 <= n_in && done * Bits / 8 + 16 <= out_limit; done += 16)
+          store(out + done * Bits / 8, _mm_shuffle_epi8(merge(load(in + done)), load(gather)));
+
+        return done;
+      }
+    };
+
+    /// 12 bit data, which always start on a nibble and so fit in the 2 bytes from their first
+    template<>
+    struct kernel<12> {
+      /// Splits 8 data out of each 12 bytes
+      static inline size_t split(const byte_t* in, size_t in_len, byte_t* out, size_t n_out) {
+        const auto& m = split_mask<12>;
+        size_t done = 0;
+
+#if defined(__AVX2__)
+        const auto shuffle_256 = broadcast(m.shuffle[0]);
+        const auto shift_256 = broadcast(m.shift);
+        for (; done + 16 <= n_out && done * 3 / 2 + 12 + 16 <= in_len; done += 16) {
+          const byte_t* p = in + done * 3 / 2;
+          auto v = _mm256_mullo_epi16(_mm256_shuffle_epi8(load(p, p + 12), shuffle_256), shift_256);
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done * 2), _mm256_srli_epi16(v, 4));
+        }
+#endif
+
+        const auto shuffle = load(m.shuffle[0]);
+        const auto shift = load(m.shift);
+        for (; done + 8 <= n_out && done * 3 / 2 + 16 <= in_len; done += 8) {
+          auto v = _mm_mullo_epi16(_mm_shuffle_epi8(load(in + done * 3 / 2), shuffle), shift);
+          store(out + done * 2, _mm_srli_epi16(v, 4));
+        }
+
+        return done;
+      }
+
+      /// Combines each 8 data into 12 bytes, stopping where the data run out of bytes to overwrite
+      static inline size_t combine(const byte_t* in, size_t n_in, byte_t* out, size_t out_len) {
+        const size_t out_limit = std::min(out_len, n_in * 3 / 2);
+        const auto& gather = gather_mask<3, 4>.shuffle;
+        size_t done = 0;
+
+#if defined(__AVX2__)
+        const auto gather_256 = broadcast(gather);
+        for (; done + 16 <= n_in && done * 3 / 2 + 12 + 16 <= out_limit; done += 16) {
+          auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + done * 2));
+          v = _mm256_madd_epi16(_mm256_and_si256(v, _mm256_set1_epi16(0xfff)), _mm256_set1_epi32(0x00011000));
+          v = _mm256_shuffle_epi8(v, gather_256);
+          byte_t* p = out + done * 3 / 2;
+          store(p, _mm256_castsi256_si128(v));
+          store(p + 12, _mm256_extracti128_si256(v, 1));
+        }
+#endif
+
+        for (; done + 8 <= n_in && done * 3 / 2 + 16 <= out_limit; done += 8) {
+          auto v = _mm_madd_epi16(_mm_and_si128(load(in + done * 2), _mm_set1_epi16(0xfff)), _mm_set1_epi32(0x00011000));
+          store(out + done * 3 / 2, _mm_shuffle_epi8(v, load(gather)));
+        }
+
+        return done;
+      }
+    };
+#endif
+  }
+
   template<n_bits_rep_t Bits>
   class bit_datum {
     // Upper bound allows iteration by 2 in on_off
@@ -151,13 +607,16 @@ namespace c3::nu {
       return safe_set(new_val);
     }
     constexpr bool get_bit(size_t pos) const {
-      return pos < Bits && (_value & (1 << (Bits - pos - 1))) != 0;
+      return pos < Bits && (_value & (rep_t{1} << (Bits - pos - 1))) != 0;
     }
     constexpr void set_bit(size_t pos) {
-      if (pos < Bits) (_value |= (1 << (Bits - pos - 1)));
+      if (pos < Bits) (_value |= (rep_t{1} << (Bits - pos - 1)));
     }
     constexpr void clear_bit(size_t pos) {
-      if (pos < Bits) (_value ^= (1 << (Bits - pos - 1)));
+      if (pos < Bits) (_value &= static_cast<rep_t>(~(rep_t{1} << (Bits - pos - 1))));
+    }
+    constexpr void toggle_bit(size_t pos) {
+      if (pos < Bits) (_value ^= (rep_t{1} << (Bits - pos - 1)));
     }
 
     constexpr rep_t get() const { return _value; }
@@ -193,11 +652,16 @@ namespace c3::nu {
       return divide_ceil<size_t>(n_data * Bits, CHAR_BIT);
     }
 
-    static constexpr void split(data_const_ref in, gsl::span<bit_datum<Bits>> out) {
-      bits_const_ref b(in);
+    static inline void split(data_const_ref in, gsl::span<bit_datum<Bits>> out) {
+      static_assert(sizeof(bit_datum<Bits>) == sizeof(rep_t), "SIMD kernels treat data as their reps");
 
-      for (size_t i = 0; i < static_cast<size_t>(out.size()); ++i)
-        out[static_cast<ssize_t>(i)] = b.get_datum<Bits>(i*Bits);
+      size_t done = _bit_simd::kernel<Bits>::split(in.data(), static_cast<size_t>(in.size()),
+                                                   reinterpret_cast<byte_t*>(out.data()),
+                                                   static_cast<size_t>(out.size()));
+      bit_reader r{in, done * Bits};
+
+      for (auto& i : out.subspan(static_cast<typename decltype(out)::index_type>(done)))
+        i = r.read<Bits>();
     }
     static inline std::vector<bit_datum<Bits>> split(data_const_ref in) {
       size_t n_data = split_len(static_cast<size_t>(in.size()));
@@ -208,23 +672,25 @@ namespace c3::nu {
       return ret;
     }
 
-    static constexpr void combine(gsl::span<const bit_datum<Bits>> in,
-                                  data_ref out,
-                                  size_t offset = 0) {
-      typename decltype(in)::index_type in_pos = offset / Bits;
-      size_t in_offset = offset % Bits;
-
-      for (auto& out_byte : out) {
-        for (size_t i = 0; i < CHAR_BIT; ++i) {
-          if (in[in_pos].get_bit(in_offset++))
-            out_byte |= (1 << (CHAR_BIT - 1 - i));
-          if (in_offset == Bits) {
-            in_offset = 0;
-            ++in_pos;
-            if (in_pos == in.size()) return;
-          }
-        }
-      }
+    /// Writes the bits of in, from offset bits into it, over out
+    static inline void combine(gsl::span<const bit_datum<Bits>> in,
+                               data_ref out,
+                               size_t offset = 0) {
+      size_t done = 0;
+      if (offset == 0)
+        done = _bit_simd::kernel<Bits>::combine(reinterpret_cast<const byte_t*>(in.data()),
+                                                static_cast<size_t>(in.size()),
+                                                out.data(), static_cast<size_t>(out.size()));
+
+      auto in_pos = static_cast<typename decltype(in)::index_type>(offset / Bits + done);
+      auto in_offset = static_cast<n_bits_rep_t>(offset % Bits);
+      size_t out_bits = static_cast<size_t>(out.size()) * CHAR_BIT;
+
+      bit_writer w{out, done * Bits};
+      if (in_offset != 0 && in_pos < in.size())
+        w.write(static_cast<n_bits_rep_t>(Bits - in_offset), in[in_pos++].get());
+      for (; in_pos < in.size() && w.position() < out_bits; ++in_pos)
+        w.write(in[in_pos]);
     }
     static inline data combine(gsl::span<const bit_datum<Bits>> in, size_t offset = 0) {
       size_t n_data = combine_len(in.size() - offset / Bits);
@@ -248,7 +714,7 @@ namespace c3::nu {
 
   public:
     constexpr bit_datum<dynamic_size>& safe_set(rep_t new_val) {
-      _value = new_val & (std::numeric_limits<rep_t>::max() >> (63 - _bits));
+      _value = _bits == 0 ? 0 : new_val & (std::numeric_limits<rep_t>::max() >> (64 - _bits));
       return *this;
     }
     constexpr bit_datum<dynamic_size>& unsafe_set(rep_t new_val) {
@@ -260,13 +726,16 @@ namespace c3::nu {
       return *this;
     }
     constexpr bool get_bit(size_t pos) const {
-      return pos < _bits && (_value & (1 << (_bits - pos - 1))) != 0;
+      return pos < _bits && (_value & (rep_t{1} << (_bits - pos - 1))) != 0;
     }
     constexpr void set_bit(size_t pos) {
-      if (pos < _bits) (_value |= (1 << (_bits - pos - 1)));
+      if (pos < _bits) (_value |= (rep_t{1} << (_bits - pos - 1)));
     }
     constexpr void clear_bit(size_t pos) {
-      if (pos < _bits) (_value ^= (1 << (_bits - pos - 1)));
+      if (pos < _bits) (_value &= ~(rep_t{1} << (_bits - pos - 1)));
+    }
+    constexpr void toggle_bit(size_t pos) {
+      if (pos < _bits) (_value ^= (rep_t{1} << (_bits - pos - 1)));
     }
 
     constexpr rep_t get() const { return _value; }
@@ -303,14 +772,14 @@ namespace c3::nu {
       return divide_ceil<size_t>(n_bytes * CHAR_BIT, bits);
     }
     static constexpr size_t combine_len(size_t n_data, n_bits_rep_t bits) {
-      return divide_ceil<size_t>(n_data * bits, CHAR_BIT - 1);
+      return divide_ceil<size_t>(n_data * bits, CHAR_BIT);
     }
 
-    static constexpr void split(data_const_ref in, gsl::span<bit_datum<dynamic_size>> out, n_bits_rep_t bits) {
-      bits_const_ref b(in);
+    static inline void split(data_const_ref in, gsl::span<bit_datum<dynamic_size>> out, n_bits_rep_t bits) {
+      bit_reader r{in};
 
-      for (size_t i = 0; i < static_cast<size_t>(out.size()); ++i)
-        out[static_cast<ssize_t>(i)] = b.get_datum(i * bits, bits);
+      for (auto& i : out)
+        i = { r.read(bits), bits };
     }
     static inline std::vector<bit_datum<dynamic_size>> split(data_const_ref in, n_bits_rep_t bits) {
       size_t n_data = split_len(static_cast<size_t>(in.size()), bits);
@@ -321,24 +790,20 @@ namespace c3::nu {
       return ret;
     }
 
-    static constexpr void combine(gsl::span<const bit_datum<dynamic_size>> in,
-                                  data_ref out,
-                                  n_bits_rep_t bits,
-                                  size_t offset = 0) {
-      decltype(in)::index_type in_pos = offset / CHAR_BIT;
-      size_t in_offset = offset % CHAR_BIT;
-
-      for (auto& out_byte : out) {
-        for (size_t i = 0; i < CHAR_BIT; ++i) {
-          if (in[in_pos].get_bit(++in_offset))
-            out_byte |= (1 << (CHAR_BIT - 1 - i));
-          if (in_offset == bits) {
-            in_offset = 0;
-            ++in_pos;
-            if (in_pos == in.size()) return;
-          }
-        }
-      }
+    /// Writes the bits of in, from offset bits into it, over out
+    static inline void combine(gsl::span<const bit_datum<dynamic_size>> in,
+                               data_ref out,
+                               n_bits_rep_t bits,
+                               size_t offset = 0) {
+      auto in_pos = static_cast<decltype(in)::index_type>(offset / bits);
+      auto in_offset = static_cast<n_bits_rep_t>(offset % bits);
+      size_t out_bits = static_cast<size_t>(out.size()) * CHAR_BIT;
+
+      bit_writer w{out};
+      if (in_offset != 0 && in_pos < in.size())
+        w.write(static_cast<n_bits_rep_t>(bits - in_offset), in[in_pos++].get());
+      for (; in_pos < in.size() && w.position() < out_bits; ++in_pos)
+        w.write(bits, in[in_pos].get());
     }
     static inline data combine(gsl::span<const bit_datum<dynamic_size>> in,
                                n_bits_rep_t bits,
@@ -356,59 +821,35 @@ namespace c3::nu {
   bit_datum<Bits>::operator bit_datum<dynamic_size>() const { return { _value, Bits }; }
 
   template<n_bits_rep_t Bits>
-  constexpr bit_datum<Bits> bits_ref::get_datum(size_t pos) const noexcept {
-    bit_datum<Bits> ret;
-
-    for (n_bits_rep_t i = 0; i < Bits; ++i)
-      if (get_bit(pos + i))
-        ret.set_bit(i);
-
-    return ret;
+  inline bit_datum<Bits> bits_ref::get_datum(size_t pos) const noexcept {
+    using rep_t = typename bit_datum<Bits>::rep_t;
+    return static_cast<rep_t>(_bit_access::read_field(_ptr, _bits, pos, Bits));
   }
 
-  constexpr bit_datum<dynamic_size> bits_ref::get_datum(size_t pos, n_bits_rep_t bits) const noexcept {
-    bit_datum<dynamic_size> ret(bits);
-
-    for (n_bits_rep_t i = 0; i < bits; ++i)
-      if (get_bit(pos + i))
-        ret.set_bit(i);
-
-    return ret;
+  inline bit_datum<dynamic_size> bits_ref::get_datum(size_t pos, n_bits_rep_t bits) const noexcept {
+    return { _bit_access::read_field(_ptr, _bits, pos, bits), bits };
   }
 
-  constexpr byte_t bits_ref::get_byte(size_t pos) const noexcept{
+  inline byte_t bits_ref::get_byte(size_t pos) const noexcept{
     return get_datum<CHAR_BIT>(pos);
   }
 
   template<n_bits_rep_t Bits>
-  constexpr bit_datum<Bits> bits_const_ref::get_datum(size_t pos) const noexcept {
-    bit_datum<Bits> ret;
-
-    for (n_bits_rep_t i = 0; i < Bits; ++i)
-      if (get_bit(pos + i))
-        ret.set_bit(i);
-
-    return ret;
+  inline bit_datum<Bits> bits_const_ref::get_datum(size_t pos) const noexcept {
+    using rep_t = typename bit_datum<Bits>::rep_t;
+    return static_cast<rep_t>(_bit_access::read_field(_ptr, _bits, pos, Bits));
   }
 
-  constexpr bit_datum<dynamic_size> bits_const_ref::get_datum(size_t pos, n_bits_rep_t bits) const noexcept {
-    bit_datum<dynamic_size> ret(bits);
-
-    for (n_bits_rep_t i = 0; i < bits; ++i)
-      if (get_bit(pos + i))
-        ret.set_bit(i);
-
-    return ret;
+  inline bit_datum<dynamic_size> bits_const_ref::get_datum(size_t pos, n_bits_rep_t bits) const noexcept {
+    return { _bit_access::read_field(_ptr, _bits, pos, bits), bits };
   }
-  constexpr byte_t bits_const_ref::get_byte(size_t pos) const noexcept {
+  inline byte_t bits_const_ref::get_byte(size_t pos) const noexcept {
     return get_datum<CHAR_BIT>(pos);
   }
 
   template<n_bits_rep_t Bits>
-  constexpr void bits_ref::set_datum(size_t pos, bit_datum<Bits> b) noexcept {
-    for (size_t i = 0; i < b.BITS(); ++i)
-      if (b.get_bit(i))
-        set_bit(pos + i);
+  inline void bits_ref::set_datum(size_t pos, bit_datum<Bits> b) noexcept {
+    _bit_access::write_field(_ptr, _bits, pos, b.BITS(), b.get());
   }
 
   template<n_bits_rep_t Bits>
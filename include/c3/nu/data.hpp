@@ -1,2 +1,4 @@
 #include "c3/nu/data/base.hpp"
 #include "c3/nu/data/common_types.hpp"
+#include "c3/nu/data/byte_order.hpp"
+#include "c3/nu/data/sinks.hpp"
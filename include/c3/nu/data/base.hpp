@@ -1,10 +1,12 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
 #include <vector>
 #include <exception>
 #include <array>
 #include <type_traits>
+#include <tuple>
 
 #include <string>
 #include <cstring>
@@ -18,7 +20,33 @@ namespace c3::nu {
   // Making this a char allows implicit upcasting
   constexpr uint8_t dynamic_size = 0;
 
-  using data = std::vector<uint8_t>;
+  /// The byte order integers are serialised in
+  ///
+  /// Big-endian is the default everywhere. native skips all byte swapping, but produces host-dependent
+  /// data, so is only for data that stays on hosts of the same architecture (or in files they alone read)
+  enum class byte_order {
+    big,
+    little,
+    native = (__BYTE_ORDER == __BIG_ENDIAN ? big : little)
+  };
+
+  /// How deserialisation checks its input
+  enum class validation {
+    /// Every field is bounds checked as it is read
+    checked,
+    /// The layout of the whole buffer is checked up front, and then the fields are read without any checks.
+    /// This rejects the same inputs as checked, but keeps the checks out of the inner loops
+    validate_once
+  };
+
+  /// Owned bytes, allocated through Alloc
+  template<typename Alloc = std::allocator<uint8_t>>
+  using basic_data = std::vector<uint8_t, Alloc>;
+  using data = basic_data<>;
+  namespace pmr {
+    /// Bytes from a std::pmr::memory_resource, such as a per-request arena
+    using data = basic_data<std::pmr::polymorphic_allocator<uint8_t>>;
+  }
   using data_ref = gsl::span<uint8_t>;
   using data_const_ref = gsl::span<const uint8_t>;
   template<size_t Len>
@@ -57,17 +85,69 @@ namespace c3::nu {
   template<typename T>
   class serialisable;
 
+  template<typename T>
+  class crtp_serialisable;
+
+  template<typename T>
+  class static_serialisable;
+
+  template<typename T>
+  class crtp_static_serialisable;
+
+  template<typename T, typename = void>
+  struct _serialised_size_is_fallback;
+
+  /// True for classes that provide their own (dynamic) serialisation, whether by virtual or CRTP base
+  template<typename T>
+  constexpr bool is_serialisable_class_v =
+      std::is_base_of_v<serialisable<T>, T> || std::is_base_of_v<crtp_serialisable<T>, T>;
+
+  /// True for classes that provide their own static serialisation, whether by virtual or CRTP base
+  template<typename T>
+  constexpr bool is_static_serialisable_class_v =
+      std::is_base_of_v<static_serialisable<T>, T> || std::is_base_of_v<crtp_static_serialisable<T>, T>;
+
+  /// Gives the serialisation machinery access to the fields listed by C3_NU_FIELDS
+  struct field_access {
+    template<typename T>
+    static constexpr auto tie(T& t) -> decltype(t._fields()) { return t._fields(); }
+  };
+
+  template<typename T, typename = void>
+  struct has_fields : std::false_type {};
+
+  template<typename T>
+  struct has_fields<T, std::void_t<decltype(field_access::tie(std::declval<T&>()))>> : std::true_type {};
+  template<typename T>
+  constexpr bool has_fields_v = has_fields<T>::value;
+
   template<typename T>
   void serialise_static(const T& t, data_ref d);
 
   template<typename T>
   constexpr size_t serialised_size();
 
+  template<typename T>
+  constexpr size_t _fields_serialised_size();
+  template<typename T, byte_order Order>
+  void _serialise_fields(const T& t, data_ref d);
+  template<typename T, byte_order Order>
+  T _deserialise_fields(data_const_ref b);
+
+  /// Serialises t with its integers in the given byte order, leaving order-insensitive types as they are
+  template<typename T, byte_order Order>
+  void serialise_static(const T& t, data_ref d);
+  template<typename T, byte_order Order>
+  T deserialise(data_const_ref b);
+
   /// XXX: does not strip qualifiers, as that would confuse parameter type
   template<typename T>
   inline data serialise(const T& t) {
     if constexpr (std::is_base_of_v<serialisable<T>, T>)
       return static_cast<const serialisable<T>&>(t)._serialise();
+    else if constexpr (std::is_base_of_v<crtp_serialisable<T>, T> &&
+                       !std::is_base_of_v<crtp_static_serialisable<T>, T>)
+      return t._serialise();
     else {
       data ret(serialised_size<T>());
       serialise_static<T>(t, ret);
@@ -100,16 +180,32 @@ namespace c3::nu {
   template<typename T>
   constexpr bool is_static_serialisable_array_v = is_static_serialisable_array<T>::value;
 
+  /// Whether a deserialised T points into the buffer it was deserialised from, and so must not outlive it
+  template<typename T, typename = void>
+  struct borrows_from_input : std::bool_constant<is_fixed_span_v<T>> {};
+  template<typename T>
+  constexpr bool borrows_from_input_v = borrows_from_input<T>::value;
+
   /// XXX: does not strip qualifiers, as that would confuse return type
   template<typename T>
   inline T deserialise(data_const_ref b) {
-    if constexpr (std::is_base_of_v<serialisable<T>, T>)
+    if constexpr (is_serialisable_class_v<T>)
       return T::_deserialise(b);
     else if constexpr (is_static_serialisable_array_v<T>) {
       T ret;
       std::copy(b.begin(), b.end(), ret.begin());
       return ret;
     }
+    else if constexpr (is_fixed_span_v<T>) {
+      static_assert(std::is_same_v<typename T::element_type, const uint8_t>,
+                    "Only spans of const bytes can borrow from the input");
+      if (b.size() != T::extent)
+        throw serialisation_failure("Invalid length");
+      // Borrows from b, so must not outlive it
+      return T{b.data(), T::extent};
+    }
+    else if constexpr (has_fields_v<T>)
+      return _deserialise_fields<T, byte_order::big>(b);
     else
       return static_cast<T>(deserialise<typename std::underlying_type<T>::type>(b));
   }
@@ -119,20 +215,19 @@ namespace c3::nu {
     return deserialise({d, serialised_size<T>()});
   }
 
-  template<typename T>
-  class static_serialisable;
-
   /// XXX: returns 0 if not statically serialisable
   template<typename T>
   constexpr size_t serialised_size() {
     if constexpr (!std::is_same_v<typename remove_all<T>::type, T>)
       return serialised_size<typename remove_all<T>::type>();
-    else if constexpr (std::is_base_of_v<static_serialisable<T>, T>)
+    else if constexpr (is_static_serialisable_class_v<T>)
       return T::_serialised_size;
     else if constexpr (is_fixed_span_v<T>)
       return serialised_size<typename T::value_type>() * T::extent;
     else if constexpr (is_static_serialisable_array_v<T>)
       return serialised_size<typename T::value_type>() * std::tuple_size<T>::value;
+    else if constexpr (has_fields_v<T>)
+      return _fields_serialised_size<T>();
     else if constexpr (std::is_enum_v<T>)
       return serialised_size<typename std::underlying_type<T>::type>();
     else
@@ -153,20 +248,203 @@ namespace c3::nu {
   /// XXX: Does not check size of buffer!!!
   template<typename T>
   void serialise_static(const T& t, data_ref d) {
-    if constexpr (std::is_base_of_v<static_serialisable<T>, T>)
+    if constexpr (is_static_serialisable_class_v<T>)
       t._serialise_static(d);
     else if constexpr (is_static_serialisable_array_v<T>)
       std::copy(t.begin(), t.end(), d.begin());
+    else if constexpr (is_fixed_span_v<T>) {
+      using elem_t = typename remove_all<typename T::element_type>::type;
+      constexpr size_t elem_len = serialised_size<elem_t>();
+      for (typename T::index_type i = 0; i < T::extent; ++i)
+        serialise_static<elem_t>(t[i], { d.data() + i * elem_len, elem_len });
+    }
+    else if constexpr (has_fields_v<T>)
+      _serialise_fields<T, byte_order::big>(t, d);
     else
       serialise_static(static_cast<typename std::underlying_type<T>::type>(t), d);
   }
 
+  /// Whether the serialised form of T is its in-memory form, less the byte order of an integer
+  template<typename T>
+  constexpr bool _is_raw_field() {
+    using U = std::remove_cv_t<T>;
+    if constexpr (std::is_same_v<U, static_data<sizeof(U)>>)
+      return true;
+    else if constexpr ((std::is_integral_v<U> && !std::is_same_v<U, bool>) || std::is_enum_v<U>)
+      return serialised_size<U>() == sizeof(U) &&
+             (sizeof(U) == 1 || sizeof(U) == 2 || sizeof(U) == 4 || sizeof(U) == 8);
+    else
+      return false;
+  }
+
+  /// Converts a raw field, copied as is to or from the wire, between host and Order in place
+  ///
+  /// The conversion is its own inverse, so this does for both serialising and deserialising
+  template<byte_order Order, typename T>
+  inline void _swap_raw_field(uint8_t* p) {
+    using U = std::remove_cv_t<T>;
+    if constexpr (Order == byte_order::native || sizeof(U) == 1 || std::is_same_v<U, static_data<sizeof(U)>>)
+      return;
+    else if constexpr (sizeof(U) == 2) {
+      uint16_t i;
+      std::memcpy(&i, p, sizeof(i));
+      i = Order == byte_order::big ? htobe16(i) : htole16(i);
+      std::memcpy(p, &i, sizeof(i));
+    }
+    else if constexpr (sizeof(U) == 4) {
+      uint32_t i;
+      std::memcpy(&i, p, sizeof(i));
+      i = Order == byte_order::big ? htobe32(i) : htole32(i);
+      std::memcpy(p, &i, sizeof(i));
+    }
+    else {
+      uint64_t i;
+      std::memcpy(&i, p, sizeof(i));
+      i = Order == byte_order::big ? htobe64(i) : htole64(i);
+      std::memcpy(p, &i, sizeof(i));
+    }
+  }
+
+  template<typename Tuple>
+  struct _fields_info;
+
+  template<typename... Fields>
+  struct _fields_info<std::tuple<Fields&...>> {
+    /// 0 unless every field is statically serialisable
+    static constexpr size_t size =
+        ((serialised_size<Fields>() != 0) && ...) ? (serialised_size<Fields>() + ...) : 0;
+
+    static constexpr bool raw = (_is_raw_field<Fields>() && ...);
+
+    /// Converts every field of a packed copy at p between host and Order, in place
+    template<byte_order Order>
+    static inline void swap_packed(uint8_t* p) {
+      ((_swap_raw_field<Order, Fields>(p), p += sizeof(Fields)), ...);
+    }
+  };
+
+  template<typename T>
+  using _fields_info_t = _fields_info<decltype(field_access::tie(std::declval<T&>()))>;
+
+  template<typename T>
+  constexpr size_t _fields_serialised_size() { return _fields_info_t<T>::size; }
+
+  /// Whether the fields of t are laid out in memory exactly as they are on the wire, less byte order,
+  /// so that t can be copied whole and then have its integers swapped in place
+  ///
+  /// XXX: this cannot be constexpr, but it always optimises down to a constant
+  template<typename T>
+  inline bool _fields_are_packed(const T& t) {
+    if constexpr (!_fields_info_t<const T>::raw || !std::is_trivially_copyable_v<T> ||
+                  sizeof(T) != _fields_serialised_size<T>())
+      return false;
+    else {
+      auto* base = reinterpret_cast<const uint8_t*>(&t);
+      ptrdiff_t expected = 0;
+      bool ret = true;
+      std::apply([&](auto&... f) {
+        ((ret = ret && reinterpret_cast<const uint8_t*>(&f) - base == expected,
+          expected += static_cast<ptrdiff_t>(sizeof(f))), ...);
+      }, field_access::tie(t));
+      return ret;
+    }
+  }
+
+  template<typename T, byte_order Order>
+  void _serialise_fields(const T& t, data_ref d) {
+    static_assert(_fields_serialised_size<T>() != 0, "C3_NU_FIELDS only supports statically sized fields");
+
+    if (_fields_are_packed(t)) {
+      std::memcpy(d.data(), &t, sizeof(T));
+      _fields_info_t<const T>::template swap_packed<Order>(d.data());
+      return;
+    }
+
+    // Otherwise, an unrolled field-by-field copy, which the compiler is free to vectorise
+    auto* pos = d.data();
+    auto one = [&](const auto& f) {
+      using F = typename remove_all<decltype(f)>::type;
+      if constexpr (Order == byte_order::big)
+        serialise_static<F>(f, { pos, serialised_size<F>() });
+      else
+        serialise_static<F, Order>(f, { pos, serialised_size<F>() });
+      pos += serialised_size<F>();
+    };
+    std::apply([&](auto&... f) { (one(f), ...); }, field_access::tie(t));
+  }
+
+  template<typename T, byte_order Order>
+  T _deserialise_fields(data_const_ref b) {
+    static_assert(_fields_serialised_size<T>() != 0, "C3_NU_FIELDS only supports statically sized fields");
+
+    if (static_cast<size_t>(b.size()) != _fields_serialised_size<T>())
+      throw serialisation_failure("Invalid length");
+
+    T ret;
+
+    if (_fields_are_packed(ret)) {
+      std::memcpy(&ret, b.data(), sizeof(T));
+      _fields_info_t<T>::template swap_packed<Order>(reinterpret_cast<uint8_t*>(&ret));
+      return ret;
+    }
+
+    auto* pos = b.data();
+    auto one = [&](auto& f) {
+      using F = typename remove_all<decltype(f)>::type;
+      if constexpr (Order == byte_order::big)
+        f = deserialise<F>({ pos, serialised_size<F>() });
+      else
+        f = deserialise<F, Order>({ pos, serialised_size<F>() });
+      pos += serialised_size<F>();
+    };
+    std::apply([&](auto&... f) { (one(f), ...); }, field_access::tie(ret));
+
+    return ret;
+  }
+
+  /// Serialises t onto the end of the sink s, without an intermediate buffer where possible
+  template<typename T, typename Sink>
+  inline void serialise_into(const T& t, Sink& s) {
+    if constexpr (is_static_serialisable_v<T>)
+      serialise_static<T>(t, s.claim(serialised_size<T>()));
+    else if constexpr (is_serialisable_class_v<T>)
+      t._serialise_into(s);
+    else
+      s.append(serialise<T>(t));
+  }
+
+  /// The number of bytes that serialising t would produce
+  ///
+  /// XXX: falls back to actually serialising t, so types that can do better should
+  /// provide an overload, or hide _serialised_size_of if they are serialisable
+  template<typename T>
+  constexpr size_t serialised_size_of(const T& t) {
+    if constexpr (is_static_serialisable_v<T>)
+      return serialised_size<T>();
+    else if constexpr (is_serialisable_class_v<T>)
+      return t._serialised_size_of();
+    else
+      return serialise<T>(t).size();
+  }
+
   template<typename T>
   class serialisable {
     friend data serialise<T>(const T&);
+    template<typename U, typename Sink>
+    friend void serialise_into(const U&, Sink&);
+    template<typename U>
+    friend constexpr size_t serialised_size_of(const U&);
+    template<typename U, typename>
+    friend struct _serialised_size_is_fallback;
   private:
     virtual data _serialise() const = 0;
 
+    /// Types that can write directly into a sink should hide this
+    template<typename Sink>
+    inline void _serialise_into(Sink& s) const { s.append(_serialise()); }
+    /// Types that know their size without serialising should hide this
+    inline size_t _serialised_size_of() const { return _serialise().size(); }
+
   public:
     virtual ~serialisable() = default;
   };
@@ -189,6 +467,62 @@ namespace c3::nu {
     virtual ~static_serialisable() = default;
   };
 
+  /// As serialisable, but dispatched at compile time rather than through a vtable
+  ///
+  /// This keeps small types small, and lets the compiler inline their serialisation into loops.
+  /// T must provide _serialise and _deserialise (the C3_NU_*_CRTP_* macros do this), and cannot
+  /// be serialised through a pointer to this base.
+  template<typename T>
+  class crtp_serialisable {
+    template<typename U, typename Sink>
+    friend void serialise_into(const U&, Sink&);
+    template<typename U>
+    friend constexpr size_t serialised_size_of(const U&);
+    template<typename U, typename>
+    friend struct _serialised_size_is_fallback;
+  private:
+    /// Types that can write directly into a sink should hide this
+    template<typename Sink>
+    inline void _serialise_into(Sink& s) const { s.append(static_cast<const T&>(*this)._serialise()); }
+    /// Types that know their size without serialising should hide this
+    inline size_t _serialised_size_of() const { return static_cast<const T&>(*this)._serialise().size(); }
+
+  protected:
+    ~crtp_serialisable() = default;
+  };
+
+  /// As static_serialisable, but dispatched at compile time rather than through a vtable
+  ///
+  /// T must provide _serialised_size, _serialise_static and _deserialise
+  template<typename T>
+  class crtp_static_serialisable : public crtp_serialisable<T> {
+  protected:
+    ~crtp_static_serialisable() = default;
+  };
+
+  /// True when T leaves _serialised_size_of to its base, which serialises T to find out
+  ///
+  /// A T that hides it privately cannot be named here, but then it is not the fallback either
+  template<typename T, typename>
+  struct _serialised_size_is_fallback : std::false_type {};
+  template<typename T>
+  struct _serialised_size_is_fallback<T, std::void_t<decltype(&T::_serialised_size_of)>> :
+    std::bool_constant<
+      std::is_same_v<decltype(&T::_serialised_size_of), size_t (serialisable<T>::*)() const> ||
+      std::is_same_v<decltype(&T::_serialised_size_of), size_t (crtp_serialisable<T>::*)() const>
+    > {};
+
+  /// Whether serialised_size_of finds the size of a T without serialising it
+  ///
+  /// Squashes only size their elements up front when this holds, as otherwise every element would be
+  /// serialised once to size it and again to write it
+  template<typename T, typename = void>
+  struct knows_serialised_size : std::bool_constant<
+    is_static_serialisable_v<T> || (is_serialisable_class_v<T> && !_serialised_size_is_fallback<T>::value)
+  > {};
+  template<typename T>
+  constexpr bool knows_serialised_size_v = knows_serialised_size<std::decay_t<T>>::value;
+
   /// XXX: does not check the size of the output buffer
   template<typename Head, typename... Tail>
   inline void serialise_all(gsl::span<data> output, Head head, Tail... tail){
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "c3/nu/data/base.hpp"
+#include "c3/nu/data/common_types.hpp"
+#include "c3/nu/data/byteswap.hpp"
+
+namespace c3::nu {
+  /// XXX: types without integers of their own (strings, classes, byte spans) keep their usual format,
+  /// as do big-endian integers, which are handled by the unordered specialisations
+  template<typename T, byte_order Order>
+  inline void serialise_static(const T& t, data_ref d) {
+    if constexpr (Order == byte_order::big)
+      serialise_static<T>(t, d);
+    else if constexpr (is_bulk_serialisable_int_v<T>)
+      byteswap_copy<sizeof(T), Order>(d.data(), reinterpret_cast<const uint8_t*>(&t), 1);
+    else if constexpr (std::is_enum_v<T>) {
+      using base_t = typename std::underlying_type<T>::type;
+      serialise_static<base_t, Order>(static_cast<base_t>(t), d);
+    }
+    else if constexpr (is_static_serialisable_array_v<T>) {
+      using elem_t = typename T::value_type;
+      if constexpr (is_bulk_serialisable_int_v<elem_t>)
+        bulk_serialise_static<elem_t, Order>(t.data(), t.size(), d.data());
+      else {
+        constexpr auto elem_len = serialised_size<elem_t>();
+        for (size_t i = 0; i < t.size(); ++i)
+          serialise_static<elem_t, Order>(t[i], { d.data() + i * elem_len, elem_len });
+      }
+    }
+    else if constexpr (has_fields_v<T>)
+      _serialise_fields<T, Order>(t, d);
+    else
+      serialise_static<T>(t, d);
+  }
+
+  template<typename T, byte_order Order>
+  inline T deserialise(data_const_ref b) {
+    if constexpr (Order == byte_order::big)
+      return deserialise<T>(b);
+    else if constexpr (is_bulk_serialisable_int_v<T>) {
+      if (b.size() != sizeof(T))
+        throw serialisation_failure("Invalid length");
+      T ret;
+      byteswap_copy<sizeof(T), Order>(reinterpret_cast<uint8_t*>(&ret), b.data(), 1);
+      return ret;
+    }
+    else if constexpr (std::is_enum_v<T>)
+      return static_cast<T>(deserialise<typename std::underlying_type<T>::type, Order>(b));
+    else if constexpr (is_static_serialisable_array_v<T>) {
+      using elem_t = typename T::value_type;
+      if (static_cast<size_t>(b.size()) != serialised_size<T>())
+        throw serialisation_failure("Invalid length");
+
+      T ret;
+      if constexpr (is_bulk_serialisable_int_v<elem_t>)
+        bulk_deserialise<elem_t, Order>(b.data(), ret.size(), ret.data());
+      else {
+        constexpr auto elem_len = serialised_size<elem_t>();
+        for (size_t i = 0; i < ret.size(); ++i)
+          ret[i] = deserialise<elem_t, Order>(b.subspan(i * elem_len, elem_len));
+      }
+      return ret;
+    }
+    else if constexpr (has_fields_v<T>)
+      return _deserialise_fields<T, Order>(b);
+    else
+      return deserialise<T>(b);
+  }
+
+  /// Deserialises a statically sized T from the serialised_size<T>() bytes at p, which must already be known
+  /// to be there
+  template<typename T, byte_order Order = byte_order::big>
+  inline T deserialise_unchecked(const uint8_t* p) {
+    static_assert(is_static_serialisable_v<T>, "Only statically sized types can be read unchecked");
+
+    if constexpr (is_bulk_serialisable_int_v<T>) {
+      T ret;
+      byteswap_copy<sizeof(T), Order>(reinterpret_cast<uint8_t*>(&ret), p, 1);
+      return ret;
+    }
+    else if constexpr (std::is_enum_v<T>)
+      return static_cast<T>(deserialise_unchecked<typename std::underlying_type<T>::type, Order>(p));
+    else
+      return deserialise<T, Order>(data_const_ref{p, static_cast<data_const_ref::index_type>(serialised_size<T>())});
+  }
+}
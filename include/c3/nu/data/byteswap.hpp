@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "c3/nu/data/base.hpp"
+#include "c3/nu/endian.hpp"
+
+namespace c3::nu {
+  /// Whether T is one of the plain integers whose serialised form is just its big-endian bytes,
+  /// and so whose sequences can be converted in bulk
+  template<typename T>
+  constexpr bool is_bulk_serialisable_int_v =
+      std::is_integral_v<T> && !std::is_same_v<T, bool> && serialised_size<T>() == sizeof(T);
+
+  namespace _byteswap {
+    /// A pshufb mask reversing every Width byte group, repeated across both AVX2 lanes
+    template<size_t Width>
+    struct shuffle_mask {
+      alignas(32) uint8_t bytes[32];
+
+      constexpr shuffle_mask() : bytes{} {
+        for (size_t i = 0; i < 32; ++i)
+          bytes[i] = static_cast<uint8_t>((i % 16) / Width * Width + (Width - 1 - i % Width));
+      }
+    };
+    template<size_t Width>
+    inline constexpr shuffle_mask<Width> mask{};
+
+    template<size_t Width, byte_order Order>
+    inline void swap_one(uint8_t* dst, const uint8_t* src) {
+      if constexpr (Width == 2) {
+        uint16_t i;
+        std::memcpy(&i, src, sizeof(i));
+        i = Order == byte_order::big ? htobe16(i) : htole16(i);
+        std::memcpy(dst, &i, sizeof(i));
+      }
+      else if constexpr (Width == 4) {
+        uint32_t i;
+        std::memcpy(&i, src, sizeof(i));
+        i = Order == byte_order::big ? htobe32(i) : htole32(i);
+        std::memcpy(dst, &i, sizeof(i));
+      }
+      else {
+        uint64_t i;
+        std::memcpy(&i, src, sizeof(i));
+        i = Order == byte_order::big ? htobe64(i) : htole64(i);
+        std::memcpy(dst, &i, sizeof(i));
+      }
+    }
+  }
+
+  /// Copies n integers of Width bytes from src to dst, converting each between host and Order
+  ///
+  /// The conversion is its own inverse, so this both serialises and deserialises.
+  /// Neither pointer needs to be aligned, but the two ranges must not overlap
+  template<size_t Width, byte_order Order = byte_order::big>
+  inline void byteswap_copy(uint8_t* dst, const uint8_t* src, size_t n) {
+    static_assert(Width == 1 || Width == 2 || Width == 4 || Width == 8, "Unsupported integer width");
+
+    size_t len = n * Width;
+
+    if constexpr (Width == 1 || Order == byte_order::native) {
+      if (len != 0)
+        std::memcpy(dst, src, len);
+    }
+    else {
+      size_t i = 0;
+
+#if defined(__AVX2__)
+      const auto mask_256 = _mm256_load_si256(reinterpret_cast<const __m256i*>(_byteswap::mask<Width>.bytes));
+      for (; i + 32 <= len; i += 32) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(block, mask_256));
+      }
+#endif
+#if defined(__SSSE3__)
+      const auto mask_128 = _mm_load_si128(reinterpret_cast<const __m128i*>(_byteswap::mask<Width>.bytes));
+      for (; i + 16 <= len; i += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(block, mask_128));
+      }
+#endif
+
+      // Without SIMD this loop still vectorises well, as each element is independent
+      for (; i < len; i += Width)
+        _byteswap::swap_one<Width, Order>(dst + i, src + i);
+    }
+  }
+
+  /// Serialises n integers from src into the n * sizeof(T) bytes at dst
+  template<typename T, byte_order Order = byte_order::big>
+  inline void bulk_serialise_static(const T* src, size_t n, uint8_t* dst) {
+    static_assert(is_bulk_serialisable_int_v<T>, "Only plain integers can be serialised in bulk");
+    byteswap_copy<sizeof(T), Order>(dst, reinterpret_cast<const uint8_t*>(src), n);
+  }
+
+  /// Deserialises n integers from the n * sizeof(T) bytes at src into dst
+  template<typename T, byte_order Order = byte_order::big>
+  inline void bulk_deserialise(const uint8_t* src, size_t n, T* dst) {
+    static_assert(is_bulk_serialisable_int_v<T>, "Only plain integers can be deserialised in bulk");
+    byteswap_copy<sizeof(T), Order>(reinterpret_cast<uint8_t*>(dst), src, n);
+  }
+}
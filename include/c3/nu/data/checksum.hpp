@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#include "c3/nu/data/base.hpp"
+
+namespace c3::nu {
+  namespace _crc32c {
+    /// The reflected Castagnoli polynomial
+    constexpr uint32_t poly = 0x82f63b78;
+
+    /// Slice-by-8 tables, so that 8 bytes are folded in per step
+    struct tables {
+      uint32_t t[8][256];
+
+      constexpr tables() : t{} {
+        for (uint32_t i = 0; i < 256; ++i) {
+          uint32_t crc = i;
+          for (int j = 0; j < 8; ++j)
+            crc = (crc >> 1) ^ (crc & 1 ? poly : 0);
+          t[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+          for (size_t j = 1; j < 8; ++j)
+            t[j][i] = (t[j - 1][i] >> 8) ^ t[0][t[j - 1][i] & 0xff];
+      }
+    };
+    inline constexpr tables table{};
+  }
+
+  /// The CRC32C of b
+  ///
+  /// Passing the result for one buffer as crc continues it over the next,
+  /// so crc32c(b, crc32c(a)) is the CRC32C of a followed by b
+  inline uint32_t crc32c(data_const_ref b, uint32_t crc = 0) {
+    const uint8_t* pos = b.data();
+    size_t len = static_cast<size_t>(b.size());
+
+    crc = ~crc;
+
+#if defined(__SSE4_2__)
+    // The crc32 instruction uses the same polynomial, so gives the same answer as the tables
+    uint64_t crc_wide = crc;
+    for (; len >= 8; len -= 8, pos += 8) {
+      uint64_t word;
+      std::memcpy(&word, pos, sizeof(word));
+      crc_wide = _mm_crc32_u64(crc_wide, word);
+    }
+    crc = static_cast<uint32_t>(crc_wide);
+
+    for (; len > 0; --len, ++pos)
+      crc = _mm_crc32_u8(crc, *pos);
+#else
+    const auto& t = _crc32c::table.t;
+
+    for (; len >= 8; len -= 8, pos += 8) {
+      uint64_t word;
+      std::memcpy(&word, pos, sizeof(word));
+      word = le64toh(word) ^ crc;
+      crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^ t[5][(word >> 16) & 0xff] ^ t[4][(word >> 24) & 0xff] ^
+            t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^ t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+    }
+
+    for (; len > 0; --len, ++pos)
+      crc = (crc >> 8) ^ t[0][(crc ^ *pos) & 0xff];
+#endif
+
+    return ~crc;
+  }
+}
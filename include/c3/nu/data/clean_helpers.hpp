@@ -15,5 +15,21 @@
 
 #undef C3_NU_DEFINE_STATIC_DESERIALISE
 
+#undef C3_NU_CRTP_FRIENDS_INTERNAL
+
+#undef C3_NU_DEFER_CRTP_SERIALISATION_TYPE
+
+#undef C3_NU_DEFER_CRTP_SERIALISATION_VAR
+
+#undef C3_NU_DEFER_CRTP_STATIC_SERIALISATION_TYPE
+
+#undef C3_NU_DEFER_CRTP_STATIC_SERIALISATION_VAR
+
+#undef C3_NU_DEFINE_CRTP_DESERIALISE
+
+#undef C3_NU_DEFINE_CRTP_STATIC_DESERIALISE
+
+#undef C3_NU_FIELDS
+
 #undef C3_NU_SERIALISED_SIZE
 #undef C3_NU_SERIALISE_STATIC_WRAPPER
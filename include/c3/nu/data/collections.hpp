@@ -1,3 +1,8 @@
 #include "c3/nu/data/collections/static.hpp"
 #include "c3/nu/data/collections/mixed.hpp"
 #include "c3/nu/data/collections/sequence.hpp"
+#include "c3/nu/data/collections/incremental.hpp"
+#include "c3/nu/data/collections/indexed.hpp"
+#include "c3/nu/data/collections/parallel.hpp"
+#include "c3/nu/data/collections/packed.hpp"
+#include "c3/nu/data/collections/dictionary.hpp"
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "c3/nu/data.hpp"
+#include "c3/nu/data/collections/packed.hpp"
+
+// Dictionary-encoded string sequences, laid out as:
+//
+//   n_entries  varint
+//   entries    every distinct string once, in order of first appearance, each behind a SizeType prefix
+//   codes      the index of each string's entry, as squash_packed<uint32_t>
+//
+// Runs of the same string pack to nothing, and a few hundred distinct labels to a byte or so each.
+
+namespace c3::nu {
+  using dict_code_type = uint32_t;
+
+  template<typename SizeType = varint, byte_order Order = byte_order::big, typename Sink, typename Iter>
+  inline void squash_dict_into(Sink& s, Iter begin, Iter end) {
+    using category = typename std::iterator_traits<Iter>::iterator_category;
+    static_assert(std::is_base_of_v<std::forward_iterator_tag, category>,
+                  "The dictionary borrows from the input, so it must be walked twice");
+
+    // The views point into the input, which outlives this
+    std::unordered_map<std::string_view, dict_code_type> codes;
+    std::vector<std::string_view> entries;
+    std::vector<dict_code_type> encoded;
+    encoded.reserve(static_cast<size_t>(std::distance(begin, end)));
+
+    for (Iter iter = begin; iter != end; ++iter) {
+      std::string_view str = *iter;
+      auto [pos, added] = codes.try_emplace(str, static_cast<dict_code_type>(entries.size()));
+      if (added) {
+        if (entries.size() == std::numeric_limits<dict_code_type>::max())
+          throw serialisation_failure("Too many distinct strings for a dictionary");
+        entries.push_back(str);
+      }
+      encoded.push_back(pos->second);
+    }
+
+    size_t dict_len = varint_len(entries.size());
+    for (auto& i : entries)
+      dict_len += size_prefix<SizeType>::len(i.size()) + i.size();
+    s.reserve(dict_len);
+
+    encode_varint(entries.size(), s.claim(varint_len(entries.size())).data());
+    for (auto& i : entries) {
+      size_prefix<SizeType>::template write<Order>(i.size(), s);
+      s.append(data_const_ref{reinterpret_cast<const uint8_t*>(i.data()),
+                              static_cast<data_const_ref::index_type>(i.size())});
+    }
+
+    squash_packed_into<Order>(s, encoded.begin(), encoded.end());
+  }
+
+  /// Squashes a sequence of strings as a table of the distinct ones followed by a small code for each
+  template<typename SizeType = varint, byte_order Order = byte_order::big, typename Iter>
+  inline data squash_dict(Iter begin, Iter end) {
+    data ret;
+    data_sink sink{ret};
+    squash_dict_into<SizeType, Order>(sink, begin, end);
+    return ret;
+  }
+
+  /// A borrowed view over the output of squash_dict
+  ///
+  /// Decoding only allocates the entry table and the codes, and every string handed back points into
+  /// the underlying buffer, so none of them may outlive it
+  template<typename SizeType = varint, byte_order Order = byte_order::big>
+  class dict_view {
+  private:
+    std::vector<std::string_view> _entries;
+    std::vector<dict_code_type> _codes;
+
+  public:
+    inline size_t size() const { return _codes.size(); }
+    inline bool empty() const { return _codes.empty(); }
+
+    inline std::string_view operator[](size_t i) const { return _entries[_codes[i]]; }
+    inline std::string_view at(size_t i) const {
+      if (i >= _codes.size())
+        throw std::out_of_range("Dictionary index out of range");
+      return (*this)[i];
+    }
+
+    /// The index into dictionary() of the ith string
+    inline dict_code_type code(size_t i) const { return _codes.at(i); }
+    /// Every distinct string, in order of first appearance
+    inline const std::vector<std::string_view>& dictionary() const { return _entries; }
+
+    inline std::vector<std::string> to_vector() const {
+      std::vector<std::string> ret;
+      ret.reserve(_codes.size());
+      for (auto i : _codes)
+        ret.emplace_back(_entries[i]);
+      return ret;
+    }
+
+  public:
+    inline dict_view(data_const_ref b) {
+      auto n_entries = decode_varint(b);
+      // Every entry takes at least its prefix
+      if (n_entries > static_cast<uint64_t>(b.size()) / size_prefix<SizeType>::min_len)
+        throw serialisation_failure("Dictionary overruns buffer");
+
+      _entries.reserve(static_cast<size_t>(n_entries));
+      for (uint64_t i = 0; i < n_entries; ++i) {
+        auto len = size_prefix<SizeType>::template read<Order>(b);
+        if (len > static_cast<size_t>(b.size()))
+          throw serialisation_failure("Dictionary entry overruns buffer");
+        _entries.emplace_back(reinterpret_cast<const char*>(b.data()), len);
+        b = b.subspan(len);
+      }
+
+      _codes = expand_packed<dict_code_type, Order>(b);
+      for (auto i : _codes)
+        if (i >= _entries.size())
+          throw serialisation_failure("Dictionary code out of range");
+    }
+  };
+
+  template<typename SizeType = varint, byte_order Order = byte_order::big>
+  inline std::vector<std::string> expand_dict(data_const_ref b) {
+    return dict_view<SizeType, Order>{b}.to_vector();
+  }
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <optional>
+#include <tuple>
+#include <utility>
+
+#include "c3/nu/data.hpp"
+#include "c3/nu/data/collections/mixed.hpp"
+
+namespace c3::nu {
+  namespace _incremental {
+    /// Holds the bytes of an element that has only partly arrived
+    ///
+    /// Whole elements are decoded straight out of the fed chunks, so only the ragged edges are copied
+    class buffer {
+    private:
+      data _pending;
+      size_t _need = 0;
+      bool _greedy = false;
+
+    public:
+      /// Step tries to make progress from the front of its input, returning the number of bytes consumed.
+      /// When that is 0 it must call wait_for first
+      template<typename Step, typename Done>
+      inline void feed(data_const_ref b, Step&& step, Done&& done) {
+        while (b.size() > 0) {
+          if (done())
+            throw serialisation_failure("Unexpected data after the end of the collection");
+
+          if (_pending.empty()) {
+            auto consumed = step(b);
+            if (consumed == 0) {
+              _pending.assign(b.begin(), b.end());
+              return;
+            }
+            b = b.subspan(consumed);
+          }
+          else {
+            // Only top up with what the current element needs, so that later ones can skip the copy
+            auto n = _greedy ? static_cast<size_t>(b.size()) : std::min<size_t>(_need, b.size());
+            _pending.insert(_pending.end(), b.begin(), b.begin() + n);
+            b = b.subspan(n);
+
+            if (auto consumed = step(_pending); consumed != 0)
+              _pending.erase(_pending.begin(), _pending.begin() + consumed);
+          }
+        }
+      }
+
+      /// Records how many more bytes the current step needs, or that it wants everything until the end
+      inline void wait_for(size_t need, bool greedy = false) { _need = need; _greedy = greedy; }
+
+      inline size_t need() const { return _need; }
+      inline data& pending() { return _pending; }
+      inline bool empty() const { return _pending.empty(); }
+    };
+
+    /// Decodes one length prefixed element from the front of in, in two steps: the prefix, then the body
+    template<typename T, typename SizeType, byte_order Order>
+    inline size_t step_prefixed(data_const_ref in, T& out, std::optional<size_t>& body_len,
+                                buffer& buf, bool& complete) {
+      complete = false;
+      size_t consumed = 0;
+
+      if (!body_len) {
+        auto rest = in;
+        body_len = size_prefix<SizeType>::template try_read<Order>(rest);
+        if (!body_len) {
+          auto min_len = size_prefix<SizeType>::min_len;
+          auto have = static_cast<size_t>(in.size());
+          buf.wait_for(have < min_len ? min_len - have : 1);
+          return 0;
+        }
+        consumed = static_cast<size_t>(in.size() - rest.size());
+        in = rest;
+      }
+
+      // Prefixes are never empty, so an element completing here always counts as progress
+      if (static_cast<size_t>(in.size()) < *body_len) {
+        buf.wait_for(*body_len - static_cast<size_t>(in.size()));
+        return consumed;
+      }
+
+      out = deserialise<T, Order>(in.subspan(0, *body_len));
+      complete = true;
+      consumed += *body_len;
+      body_len.reset();
+      return consumed;
+    }
+  }
+
+  /// Decodes the output of squash<SizeType> as it arrives, in one pass
+  ///
+  /// The final element has no length prefix if it is dynamically sized, so only finish() can end it.
+  /// The fed chunks are not kept, so borrowing element types (std::string_view, data_const_ref) cannot be used.
+  template<typename SizeType, byte_order Order, typename... Ts>
+  class basic_incremental_expand {
+    static_assert(sizeof...(Ts) > 0, "Nothing to expand");
+    static_assert(!(borrows_from_input_v<Ts> || ...),
+                  "Borrowing element types would point into chunks that have already been dropped");
+
+  private:
+    std::tuple<Ts...> _out;
+    size_t _index = 0;
+    std::optional<size_t> _body_len;
+    _incremental::buffer _buf;
+
+  private:
+    template<size_t I>
+    static constexpr bool _is_unprefixed() {
+      using T = nth_type_t<I, Ts...>;
+      return !is_static_serialisable_v<T> && I + 1 == sizeof...(Ts);
+    }
+
+    template<size_t I>
+    inline size_t _step_at(data_const_ref in) {
+      using T = nth_type_t<I, Ts...>;
+
+      if constexpr (is_static_serialisable_v<T>) {
+        constexpr size_t len = serialised_size<T>();
+        if (static_cast<size_t>(in.size()) < len) {
+          _buf.wait_for(len - static_cast<size_t>(in.size()));
+          return 0;
+        }
+        std::get<I>(_out) = deserialise<T, Order>(in.subspan(0, len));
+        ++_index;
+        _next_wait();
+        return len;
+      }
+      else if constexpr (_is_unprefixed<I>()) {
+        _buf.wait_for(1, true);
+        return 0;
+      }
+      else {
+        bool complete;
+        auto ret = _incremental::step_prefixed<T, SizeType, Order>(in, std::get<I>(_out), _body_len, _buf, complete);
+        if (complete) {
+          ++_index;
+          _next_wait();
+        }
+        return ret;
+      }
+    }
+
+    template<size_t... Is>
+    inline size_t _step_impl(data_const_ref in, std::index_sequence<Is...>) {
+      size_t ret = 0;
+      ((_index == Is ? (ret = _step_at<Is>(in), true) : false) || ...);
+      return ret;
+    }
+
+    inline size_t _step(data_const_ref in) {
+      if (done())
+        return 0;
+      return _step_impl(in, std::index_sequence_for<Ts...>{});
+    }
+
+    /// Works out what the next element will need before it has seen any of it, so that need() is accurate
+    inline void _next_wait() {
+      if (!done())
+        _step(data_const_ref{});
+    }
+
+  public:
+    inline void feed(data_const_ref b) {
+      _buf.feed(b, [this](data_const_ref in) { return _step(in); }, [this] { return done(); });
+    }
+
+    /// Marks the end of the input, which completes the final element if it has no length prefix
+    inline void finish() {
+      if (!done()) {
+        _finish_last();
+        if (!done())
+          throw serialisation_failure("Input ended part way through the collection");
+      }
+    }
+
+    /// At least this many more bytes are needed before the next element can be decoded
+    ///
+    /// XXX: an unprefixed final element reports 1, as it can only be ended by finish()
+    inline size_t need() const { return done() ? 0 : _buf.need(); }
+    inline bool done() const { return _index == sizeof...(Ts); }
+    /// The number of elements decoded so far
+    inline size_t n_done() const { return _index; }
+
+    inline std::tuple<Ts...>& get() {
+      if (!done())
+        throw serialisation_failure("Collection is incomplete");
+      return _out;
+    }
+    inline std::tuple<Ts...> take() { return std::move(get()); }
+
+  private:
+    inline void _finish_last() {
+      constexpr size_t last = sizeof...(Ts) - 1;
+      if constexpr (_is_unprefixed<last>()) {
+        if (_index == last) {
+          std::get<last>(_out) = deserialise<nth_type_t<last, Ts...>, Order>(_buf.pending());
+          _buf.pending().clear();
+          ++_index;
+        }
+      }
+    }
+
+  public:
+    inline basic_incremental_expand() { _next_wait(); }
+  };
+
+  template<typename SizeType, typename... Ts>
+  using incremental_expand = basic_incremental_expand<SizeType, byte_order::big, Ts...>;
+
+  /// Decodes the output of squash_seq as it arrives, in one pass
+  ///
+  /// Sequences carry no count, so only finish() can end one. Elements can be taken as they complete.
+  /// As with incremental_expand, borrowing element types cannot be used.
+  template<typename T, typename SizeType = void, byte_order Order = byte_order::big>
+  class incremental_expand_seq {
+  public:
+    static constexpr bool is_static = is_static_serialisable_v<T>;
+    static_assert(is_static == std::is_void_v<SizeType>,
+                  "A SizeType must be given iff the elements are dynamically sized");
+    static_assert(!borrows_from_input_v<T>,
+                  "Borrowing element types would point into chunks that have already been dropped");
+
+  private:
+    std::vector<T> _out;
+    std::optional<size_t> _body_len;
+    _incremental::buffer _buf;
+    bool _finished = false;
+
+  private:
+    inline size_t _step(data_const_ref in) {
+      if constexpr (is_static) {
+        // Decode every whole element available in one go, so that bulk types stay bulk
+        constexpr size_t len = serialised_size<T>();
+        size_t n = static_cast<size_t>(in.size()) / len;
+        if (n == 0) {
+          _buf.wait_for(len - static_cast<size_t>(in.size()));
+          return 0;
+        }
+
+        auto decoded = expand_seq<T, Order>(in.subspan(0, n * len));
+        if (_out.empty())
+          _out = std::move(decoded);
+        else
+          _out.insert(_out.end(), std::make_move_iterator(decoded.begin()), std::make_move_iterator(decoded.end()));
+
+        _buf.wait_for(len);
+        return n * len;
+      }
+      else {
+        size_t ret = 0;
+        while (true) {
+          bool complete;
+          T elem;
+          auto consumed = _incremental::step_prefixed<T, SizeType, Order>(in.subspan(ret), elem, _body_len,
+                                                                          _buf, complete);
+          if (complete)
+            _out.emplace_back(std::move(elem));
+          else if (consumed == 0)
+            return ret;
+          ret += consumed;
+        }
+      }
+    }
+
+  public:
+    inline void feed(data_const_ref b) {
+      _buf.feed(b, [this](data_const_ref in) { return _step(in); }, [this] { return _finished; });
+    }
+
+    inline void finish() {
+      if (!_buf.empty() || _body_len)
+        throw serialisation_failure("Input ended part way through an element");
+      _finished = true;
+    }
+
+    inline size_t need() const { return _finished ? 0 : _buf.need(); }
+    inline bool done() const { return _finished; }
+
+    /// The elements decoded so far
+    inline const std::vector<T>& get() const { return _out; }
+    /// Moves out the elements decoded so far, so that they can be handled before the rest arrive
+    inline std::vector<T> take() { return std::exchange(_out, {}); }
+
+  public:
+    inline incremental_expand_seq() { _step(data_const_ref{}); }
+  };
+}
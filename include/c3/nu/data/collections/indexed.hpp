@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <stdexcept>
+
+#include "c3/nu/data.hpp"
+#include "c3/nu/data/collections/mixed.hpp"
+
+namespace c3::nu {
+  /// The bytes of the offset table squash_indexed writes for n fields
+  template<typename OffsetType>
+  constexpr size_t offset_table_size(size_t n) {
+    return n == 0 ? 0 : (n - 1) * serialised_size<OffsetType>();
+  }
+
+  /// The number of bytes squash_indexed<OffsetType> would produce
+  template<typename OffsetType = default_size_type, typename... Ts>
+  inline size_t squashed_indexed_size(const Ts&... ts) {
+    size_t ret = offset_table_size<OffsetType>(sizeof...(Ts));
+    bool ok = (integer_try_add(ret, serialised_size_of(ts)) && ...);
+    if (!ok)
+      throw serialisation_failure("Squashed size overflows size_t");
+    return ret;
+  }
+
+  namespace _indexed {
+    /// Fills in the table from where each field ends, relative to the end of the table
+    template<typename OffsetType, byte_order Order, size_t N>
+    inline void write_table(data_ref table, const std::array<size_t, N>& ends) {
+      for (size_t i = 0; i + 1 < N; ++i) {
+        if (!integer_can_hold<OffsetType>(ends[i]))
+          throw serialisation_failure("OffsetType was too small to hold an offset");
+        serialise_static<OffsetType, Order>(static_cast<OffsetType>(ends[i]),
+                                            table.subspan(i * serialised_size<OffsetType>(),
+                                                          serialised_size<OffsetType>()));
+      }
+    }
+  }
+
+  /// Squashes the arguments behind a table of where each one starts, so that any one can be found in O(1)
+  ///
+  /// The format is the start offsets of fields 1 to N - 1 (relative to the end of the table) as OffsetTypes,
+  /// followed by the fields themselves with no length prefixes
+  template<typename OffsetType = default_size_type, byte_order Order = byte_order::big,
+           typename Sink, typename... Ts>
+  inline void squash_indexed_into(Sink& s, const Ts&... ts) {
+    static_assert(sizeof...(Ts) > 0, "Nothing to squash");
+    constexpr auto table_len = offset_table_size<OffsetType>(sizeof...(Ts));
+    std::array<size_t, sizeof...(Ts)> ends;
+
+    if constexpr ((knows_serialised_size_v<Ts> && ...) || !_prefixed::has_written<Sink>::value) {
+      ends = { serialised_size_of(ts)... };
+      for (size_t i = 1; i < ends.size(); ++i)
+        if (!integer_try_add(ends[i], ends[i - 1]))
+          throw serialisation_failure("Squashed size overflows size_t");
+      auto total = ends.back();
+      if (!integer_try_add(total, table_len))
+        throw serialisation_failure("Squashed size overflows size_t");
+
+      s.reserve(total);
+      _indexed::write_table<OffsetType, Order>(s.claim(table_len), ends);
+
+      auto start = s.size();
+      (serialise_into<Order>(ts, s), ...);
+      if (s.size() - start != ends.back())
+        throw serialisation_failure("serialised_size_of disagreed with the serialised length");
+    }
+    else {
+      // Sizing these fields would serialise them, so serialise them once and fill the table in afterwards
+      auto table_pos = s.size();
+      s.claim(table_len);
+
+      auto start = s.size();
+      size_t i = 0;
+      ((serialise_into<Order>(ts, s), ends[i++] = s.size() - start), ...);
+
+      _indexed::write_table<OffsetType, Order>(
+        s.written().subspan(static_cast<data_ref::index_type>(table_pos), table_len), ends);
+    }
+  }
+
+  template<typename OffsetType = default_size_type, byte_order Order = byte_order::big, typename... Ts>
+  inline data squash_indexed(const Ts&... ts) {
+    data ret;
+    data_sink sink{ret};
+    squash_indexed_into<OffsetType, Order>(sink, ts...);
+    return ret;
+  }
+
+  /// A borrowed view over the output of squash_indexed, giving any field in O(1) without decoding the others
+  ///
+  /// The whole table is checked on construction, so that every later lookup is just two offset reads
+  template<typename OffsetType, byte_order Order, typename... Ts>
+  class basic_squash_view {
+    static_assert(sizeof...(Ts) > 0, "Nothing to view");
+
+  private:
+    data_const_ref _table;
+    data_const_ref _fields;
+
+  private:
+    inline size_t _start(size_t n) const {
+      if (n == 0)
+        return 0;
+      auto len = serialised_size<OffsetType>();
+      return static_cast<size_t>(deserialise<OffsetType, Order>(_table.subspan((n - 1) * len, len)));
+    }
+    inline size_t _end(size_t n) const {
+      return n + 1 == sizeof...(Ts) ? static_cast<size_t>(_fields.size()) : _start(n + 1);
+    }
+
+    template<size_t... Is>
+    inline void _check_static_sizes(std::index_sequence<Is...>) const {
+      bool ok = ((!is_static_serialisable_v<nth_type_t<Is, Ts...>> ||
+                  _end(Is) - _start(Is) == serialised_size<nth_type_t<Is, Ts...>>()) && ...);
+      if (!ok)
+        throw serialisation_failure("Static field has the wrong length");
+    }
+
+  public:
+    static constexpr size_t size() { return sizeof...(Ts); }
+
+    /// The serialised form of field n, borrowed from the underlying buffer
+    inline data_const_ref raw(size_t n) const {
+      if (n >= sizeof...(Ts))
+        throw std::out_of_range("Field index out of range");
+      auto start = _start(n);
+      return _fields.subspan(start, _end(n) - start);
+    }
+
+    template<size_t I>
+    inline nth_type_t<I, Ts...> get() const {
+      static_assert(I < sizeof...(Ts), "Field index out of range");
+      return deserialise<nth_type_t<I, Ts...>, Order>(raw(I));
+    }
+
+  public:
+    inline basic_squash_view(data_const_ref b) {
+      auto table_len = offset_table_size<OffsetType>(sizeof...(Ts));
+      if (static_cast<size_t>(b.size()) < table_len)
+        throw serialisation_failure("Buffer too small for the offset table");
+      _table = b.subspan(0, table_len);
+      _fields = b.subspan(table_len);
+
+      size_t prev = 0;
+      for (size_t i = 1; i < sizeof...(Ts); ++i) {
+        auto start = _start(i);
+        if (start < prev || start > static_cast<size_t>(_fields.size()))
+          throw serialisation_failure("Corrupt offset table");
+        prev = start;
+      }
+
+      _check_static_sizes(std::index_sequence_for<Ts...>{});
+    }
+  };
+
+  template<typename OffsetType, typename... Ts>
+  using squash_view = basic_squash_view<OffsetType, byte_order::big, Ts...>;
+}
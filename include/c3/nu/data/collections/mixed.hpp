@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <utility>
+
 #include "c3/nu/integer.hpp"
 #include "c3/nu/data.hpp"
 
@@ -8,43 +11,147 @@ namespace c3::nu {
   /// Used to enforce hybrid/static serialisation
   using hybrid_collection = void;
 
-  template<typename SizeType = hybrid_collection, typename Head, typename... Tail>
-  inline void _squash_internal(data& acc, Head&& head, Tail&&... tail) {
-    if constexpr (is_static_serialisable_v<Head>) {
-      auto current_len = acc.size();
-      acc.resize(current_len + serialised_size<Head>());
-      data_ref to_fill{acc.data() + current_len, serialised_size<Head>()};
-      serialise_static(head, to_fill);
-    }
-    else {
-      data buf = serialise(head);
-      if constexpr (sizeof...(Tail) != 0) {
-        if (buf.size() > std::numeric_limits<SizeType>::max()) {
-          throw serialisation_failure("SizeType was too small to hold a value");
-        }
-
-        SizeType len = static_cast<SizeType>(buf.size());
-        auto current_len = acc.size();
-        acc.resize(current_len + serialised_size<SizeType>());
-        data_ref to_fill{acc.data() + current_len, serialised_size<SizeType>()};
-        serialise_static(len, to_fill);
-      }
-      acc.insert(acc.end(), buf.begin(), buf.end());
-    }
+  /// Adds up the squashed size of each argument, given their serialised lengths
+  template<typename SizeType, typename Head, typename... Tail>
+  inline size_t _squashed_size(const size_t* lens) {
+    size_t ret = *lens;
+    if constexpr (!(is_static_serialisable_v<Head> || sizeof...(Tail) == 0))
+      if (!integer_try_add(ret, size_prefix<SizeType>::len(*lens)))
+        throw serialisation_failure("Squashed size overflows size_t");
 
     if constexpr (sizeof...(Tail) != 0)
-      _squash_internal<SizeType>(acc, tail...);
+      if (!integer_try_add(ret, _squashed_size<SizeType, Tail...>(lens + 1)))
+        throw serialisation_failure("Squashed size overflows size_t");
+
+    return ret;
   }
 
+  /// The number of bytes squash<SizeType> would produce, so that the output can be allocated once
   template<typename SizeType = hybrid_collection, typename Head, typename... Tail>
+  inline size_t squashed_size(const Head& head, const Tail&... tail) {
+    std::array<size_t, sizeof...(Tail) + 1> lens = { serialised_size_of(head), serialised_size_of(tail)... };
+    return _squashed_size<SizeType, Head, Tail...>(lens.data());
+  }
+
+  /// lens holds the serialised length of each argument, or is null if they are not known
+  template<typename SizeType, byte_order Order, typename Sink, typename Head, typename... Tail>
+  inline void _squash_internal(Sink& acc, const size_t* lens, Head&& head, Tail&&... tail) {
+    // The final element has no length prefix, as it just takes the rest of the buffer
+    if constexpr (is_static_serialisable_v<Head> || sizeof...(Tail) == 0)
+      serialise_into<Order>(head, acc);
+    else if (lens)
+      serialise_into_prefixed<SizeType, Order>(head, *lens, acc);
+    else
+      serialise_into_prefixed<SizeType, Order>(head, acc);
+
+    if constexpr (sizeof...(Tail) != 0)
+      _squash_internal<SizeType, Order>(acc, lens ? lens + 1 : nullptr, tail...);
+  }
+
+  /// Squashes the arguments onto the end of s, in the same format as squash
+  ///
+  /// If every argument can be sized without serialising it, s is reserved up front
+  template<typename SizeType, byte_order Order, typename Sink, typename Head, typename... Tail>
+  inline void squash_into(Sink& s, Head&& head, Tail&&... tail) {
+    if constexpr ((knows_serialised_size_v<Head> && ... && knows_serialised_size_v<Tail>)) {
+      std::array<size_t, sizeof...(Tail) + 1> lens = { serialised_size_of(head), serialised_size_of(tail)... };
+      s.reserve(_squashed_size<SizeType, std::decay_t<Head>, std::decay_t<Tail>...>(lens.data()));
+      _squash_internal<SizeType, Order>(s, lens.data(), head, tail...);
+    }
+    else
+      _squash_internal<SizeType, Order>(s, nullptr, head, tail...);
+  }
+
+  template<typename SizeType = hybrid_collection, typename Sink, typename Head, typename... Tail>
+  inline void squash_into(Sink& s, Head&& head, Tail&&... tail) {
+    squash_into<SizeType, byte_order::big>(s, head, tail...);
+  }
+
+  /// Squashes the arguments with their integers (and length prefixes) in the given byte order
+  template<typename SizeType, byte_order Order, typename Head, typename... Tail>
   inline data squash(Head&& head, Tail... tail) {
     data ret;
-    _squash_internal<SizeType>(ret, head, tail...);
+    data_sink sink{ret};
+    squash_into<SizeType, Order>(sink, head, tail...);
     return ret;
   }
 
   template<typename SizeType = hybrid_collection, typename Head, typename... Tail>
+  inline data squash(Head&& head, Tail... tail) {
+    return squash<SizeType, byte_order::big>(head, tail...);
+  }
+
+  /// As squash, but allocating the output from mr
+  ///
+  /// Resource is only a template parameter so that a pointer to a derived resource is an exact match,
+  /// and so this is chosen over serialising the pointer
+  template<typename SizeType, byte_order Order, typename Resource, typename Head, typename... Tail>
+  inline std::enable_if_t<std::is_base_of_v<std::pmr::memory_resource, Resource>, pmr::data>
+  squash(Resource* mr, Head&& head, Tail... tail) {
+    pmr::data ret{mr};
+    pmr::data_sink sink{ret};
+    squash_into<SizeType, Order>(sink, head, tail...);
+    return ret;
+  }
+
+  template<typename SizeType = hybrid_collection, typename Resource, typename Head, typename... Tail>
+  inline std::enable_if_t<std::is_base_of_v<std::pmr::memory_resource, Resource>, pmr::data>
+  squash(Resource* mr, Head&& head, Tail... tail) {
+    return squash<SizeType, byte_order::big>(mr, head, tail...);
+  }
+
+  /// Finds where each of Ts starts (and the last ends) in b, checking that every prefix and field fits
+  template<typename SizeType, byte_order Order, typename... Ts, size_t... Is>
+  inline std::array<size_t, sizeof...(Ts) + 1> _expand_bounds(data_const_ref b, std::index_sequence<Is...>) {
+    std::array<size_t, sizeof...(Ts) + 1> ret{};
+    auto start = b.data();
+
+    // Ts only comes through as a null pointer, as nothing has been deserialised yet
+    auto step = [&](auto* type, auto i) {
+      using T = std::remove_pointer_t<decltype(type)>;
+      size_t len;
+      if constexpr (is_static_serialisable_v<T>)
+        len = serialised_size<T>();
+      else if constexpr (decltype(i)::value + 1 < sizeof...(Ts))
+        len = size_prefix<SizeType>::template read<Order>(b);
+      else
+        len = static_cast<size_t>(b.size());
+
+      if (len > static_cast<size_t>(b.size()))
+        throw serialisation_failure("Expanding would overrun buffer");
+      ret[i] = static_cast<size_t>(b.data() - start);
+      ret[i + 1] = ret[i] + len;
+      b = b.subspan(static_cast<data_const_ref::index_type>(len));
+    };
+    (step(static_cast<Ts*>(nullptr), std::integral_constant<size_t, Is>{}), ...);
+
+    return ret;
+  }
+
+  template<byte_order Order, typename... Ts, size_t... Is>
+  inline void _expand_unchecked(const uint8_t* p, const std::array<size_t, sizeof...(Ts) + 1>& bounds,
+                                std::index_sequence<Is...>, Ts&... ts) {
+    auto read = [&](auto& t, size_t i) {
+      using T = std::remove_reference_t<decltype(t)>;
+      if constexpr (is_static_serialisable_v<T>)
+        t = deserialise_unchecked<T, Order>(p + bounds[i]);
+      else
+        t = deserialise<T, Order>(data_const_ref{p + bounds[i],
+                                                 static_cast<data_const_ref::index_type>(bounds[i + 1] - bounds[i])});
+    };
+    (read(ts, Is), ...);
+  }
+
+  template<typename SizeType, byte_order Order, validation V = validation::checked, typename Head, typename... Tail>
   inline void expand(data_const_ref b, Head& head, Tail&... tail) {
+    if constexpr (V == validation::validate_once) {
+      // Every field is found and checked first, so reading them needs no checks at all
+      constexpr auto is = std::index_sequence_for<Head, Tail...>{};
+      auto bounds = _expand_bounds<SizeType, Order, Head, Tail...>(b, is);
+      _expand_unchecked<Order, Head, Tail...>(b.data(), bounds, is, head, tail...);
+      return;
+    }
+
     // We do use this, but only sometimes
     size_t our_chunk_size = 0;
     // This silences the warning on the final case, where we don't actually use it
@@ -53,24 +160,30 @@ namespace c3::nu {
     if constexpr (is_static_serialisable_v<Head>) {
       our_chunk_size = serialised_size<Head>();
       // Whilst a subspan is not strictly necessary, it does a bounds check, so we don't have to
-      head = deserialise<Head>(b.subspan(0, serialised_size<Head>()));
+      head = deserialise<Head, Order>(b.subspan(0, serialised_size<Head>()));
     }
     else {
-      if (!integer_try_add(our_chunk_size, serialised_size<SizeType>()))
-        throw serialisation_failure("Element size overflows size_t");
-
       if constexpr (sizeof...(Tail) != 0) {
-        SizeType len_s = deserialise<SizeType>(b.subspan(0, serialised_size<SizeType>()));
-        if (!integer_try_add(our_chunk_size, len_s))
-          throw serialisation_failure("Possibly fake element size overflows size_t");
-         head = deserialise<Head>(b.subspan(serialised_size<SizeType>(), static_cast<size_t>(len_s)));
+        // Moves b past the prefix
+        our_chunk_size = size_prefix<SizeType>::template read<Order>(b);
+        head = deserialise<Head, Order>(b.subspan(0, our_chunk_size));
       }
       else
-        head = deserialise<Head>(b);
+        head = deserialise<Head, Order>(b);
     }
 
     // Subspan does a bounds check, so we don't have to
     if constexpr (sizeof...(Tail) != 0)
-      expand<SizeType>(b.subspan(our_chunk_size), tail...);
+      expand<SizeType, Order>(b.subspan(our_chunk_size), tail...);
+  }
+
+  template<typename SizeType = hybrid_collection, typename Head, typename... Tail>
+  inline void expand(data_const_ref b, Head& head, Tail&... tail) {
+    expand<SizeType, byte_order::big>(b, head, tail...);
+  }
+
+  template<typename SizeType, validation V, typename Head, typename... Tail>
+  inline void expand(data_const_ref b, Head& head, Tail&... tail) {
+    expand<SizeType, byte_order::big, V>(b, head, tail...);
   }
 }
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "c3/nu/data.hpp"
+#include "c3/nu/bits.hpp"
+
+// Integer sequences as zigzagged deltas, frame-of-reference bit packed in blocks:
+//
+//   count    varint
+//   blocks   of packed_block_size values each (the last may be short), each being:
+//     first  the first value of the block, as serialise_static would write it
+//     min    the smallest zigzagged delta in the block, as a varint
+//     width  the bits used for each packed value (0 to 64), as a byte
+//     bits   every later delta as (zigzag(delta) - min), width bits each, padded to a whole byte
+//
+// The bits are packed most significant first, exactly as bits_ref::set_datum lays them out.
+
+namespace c3::nu {
+  constexpr size_t packed_block_size = 128;
+
+  namespace _packed {
+    template<typename U>
+    constexpr U zigzag(U delta) {
+      using S = std::make_signed_t<U>;
+      return static_cast<U>(delta << 1) ^ static_cast<U>(static_cast<S>(delta) >> (sizeof(U) * CHAR_BIT - 1));
+    }
+
+    template<typename U>
+    constexpr U unzigzag(U i) {
+      return static_cast<U>(i >> 1) ^ static_cast<U>(-static_cast<U>(i & 1));
+    }
+
+    constexpr uint8_t width_of(uint64_t i) {
+      uint8_t ret = 0;
+      for (; i != 0; i >>= 1, ++ret);
+      return ret;
+    }
+
+    /// Unpacks n values of Width bits each from the start of bits
+    template<unsigned Width>
+    inline void unpack(bits_const_ref bits, size_t n, uint64_t* out) {
+      if constexpr (Width == 0) {
+        std::fill(out, out + n, 0);
+      }
+      else {
+        size_t i = 0;
+
+#if defined(__AVX2__)
+        // Every 8 values start on a byte boundary, and each fits in the 4 bytes from its first,
+        // so they can be gathered, byteswapped and shifted into place together
+        if constexpr (Width <= 25) {
+          const auto offsets = _mm256_setr_epi32(0, Width / 8, 2 * Width / 8, 3 * Width / 8,
+                                                 4 * Width / 8, 5 * Width / 8, 6 * Width / 8, 7 * Width / 8);
+          const auto shifts = _mm256_setr_epi32(0, Width % 8, 2 * Width % 8, 3 * Width % 8,
+                                                4 * Width % 8, 5 * Width % 8, 6 * Width % 8, 7 * Width % 8);
+          const auto bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                              3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+          const uint8_t* p = bits.data();
+          // The last gather of each 8 reads the 4 bytes from value 7's first
+          for (; i + 8 <= n && (i + 7) * Width / 8 + 4 <= bits.safe_access_bytes(); i += 8) {
+            auto v = _mm256_i32gather_epi32(reinterpret_cast<const int*>(p + i * Width / 8), offsets, 1);
+            v = _mm256_shuffle_epi8(v, bswap);
+            v = _mm256_sllv_epi32(v, shifts);
+            v = _mm256_srli_epi32(v, 32 - Width);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                                _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 4),
+                                _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+          }
+        }
+#endif
+
+        bit_reader r{bits, i * Width};
+        for (; i < n; ++i)
+          out[i] = r.read(Width);
+      }
+    }
+
+    using unpack_fn = void (*)(bits_const_ref, size_t, uint64_t*);
+
+    template<size_t... Widths>
+    constexpr std::array<unpack_fn, sizeof...(Widths)> make_unpackers(std::index_sequence<Widths...>) {
+      return { &unpack<Widths>... };
+    }
+
+    /// Each width gets its own unpacker, so that every shift in it is a constant
+    inline constexpr auto unpackers = make_unpackers(std::make_index_sequence<65>{});
+  }
+
+  template<byte_order Order, typename Sink, typename Iter>
+  inline void squash_packed_into(Sink& s, Iter begin, Iter end) {
+    using T = typename std::iterator_traits<Iter>::value_type;
+    static_assert(is_bulk_serialisable_int_v<T>, "Only plain integers can be packed");
+    using U = std::make_unsigned_t<T>;
+
+    auto count = static_cast<uint64_t>(std::distance(begin, end));
+    encode_varint(count, s.claim(varint_len(count)).data());
+
+    std::array<U, packed_block_size> deltas;
+    while (begin != end) {
+      T first = *begin++;
+      U prev = static_cast<U>(first);
+      size_t n = 1;
+
+      U min = std::numeric_limits<U>::max();
+      U max = 0;
+      for (; n < packed_block_size && begin != end; ++n, ++begin) {
+        auto value = static_cast<U>(*begin);
+        deltas[n] = _packed::zigzag(static_cast<U>(value - prev));
+        prev = value;
+        min = std::min(min, deltas[n]);
+        max = std::max(max, deltas[n]);
+      }
+      if (n == 1)
+        min = 0;
+      auto width = _packed::width_of(static_cast<uint64_t>(max - min));
+
+      auto packed_len = divide_ceil<size_t>((n - 1) * width, CHAR_BIT);
+      data_ref out = s.claim(sizeof(T) + varint_len(min) + 1 + packed_len);
+      uint8_t* pos = out.data();
+
+      serialise_static<T, Order>(first, { pos, sizeof(T) });
+      pos += sizeof(T);
+      encode_varint(min, pos);
+      pos += varint_len(min);
+      *pos++ = width;
+
+      // Zero the padding, as the writer keeps whatever it finds past the last value
+      if (packed_len != 0)
+        pos[packed_len - 1] = 0;
+      bit_writer packer{bits_ref{pos, packed_len * CHAR_BIT}};
+      for (size_t i = 1; i < n; ++i)
+        packer.write(width, deltas[i] - min);
+      packer.flush();
+    }
+  }
+
+  template<typename Sink, typename Iter>
+  inline void squash_packed_into(Sink& s, Iter begin, Iter end) {
+    squash_packed_into<byte_order::big>(s, begin, end);
+  }
+
+  /// Squashes a sequence of integers, shrinking each to a few bits when neighbours are close together
+  template<byte_order Order, typename Iter>
+  inline data squash_packed(Iter begin, Iter end) {
+    data ret;
+    data_sink sink{ret};
+    squash_packed_into<Order>(sink, begin, end);
+    return ret;
+  }
+
+  template<typename Iter>
+  inline data squash_packed(Iter begin, Iter end) {
+    return squash_packed<byte_order::big>(begin, end);
+  }
+
+  template<typename T, byte_order Order>
+  inline std::vector<T> expand_packed(data_const_ref b) {
+    static_assert(is_bulk_serialisable_int_v<T>, "Only plain integers can be packed");
+    using U = std::make_unsigned_t<T>;
+
+    auto count = decode_varint(b);
+    // Every block takes at least its header, so a count can be checked before reserving for it
+    if (divide_ceil<uint64_t>(count, packed_block_size) > static_cast<uint64_t>(b.size()) / (sizeof(T) + 2))
+      throw serialisation_failure("Packed count overruns buffer");
+
+    std::vector<T> ret;
+    ret.reserve(static_cast<size_t>(count));
+
+    std::array<uint64_t, packed_block_size> unpacked;
+
+    while (ret.size() < count) {
+      size_t n = std::min<size_t>(packed_block_size, static_cast<size_t>(count) - ret.size());
+
+      U value = static_cast<U>(deserialise<T, Order>(b.subspan(0, sizeof(T))));
+      b = b.subspan(sizeof(T));
+      auto min = decode_varint(b);
+      if (b.size() < 1)
+        throw serialisation_failure("Packed block overruns buffer");
+      auto width = b[0];
+      b = b.subspan(1);
+      if (width > sizeof(U) * CHAR_BIT)
+        throw serialisation_failure("Invalid packed width");
+
+      auto packed_len = divide_ceil<size_t>((n - 1) * width, CHAR_BIT);
+      if (packed_len > static_cast<size_t>(b.size()))
+        throw serialisation_failure("Packed block overruns buffer");
+
+      _packed::unpackers[width]({b.data(), packed_len * CHAR_BIT}, n - 1, unpacked.data());
+      b = b.subspan(packed_len);
+
+      ret.push_back(static_cast<T>(value));
+      for (size_t i = 0; i < n - 1; ++i) {
+        value += _packed::unzigzag(static_cast<U>(unpacked[i] + min));
+        ret.push_back(static_cast<T>(value));
+      }
+    }
+
+    if (b.size() != 0)
+      throw serialisation_failure("Spare bytes after packed sequence");
+
+    return ret;
+  }
+
+  template<typename T>
+  inline std::vector<T> expand_packed(data_const_ref b) {
+    return expand_packed<T, byte_order::big>(b);
+  }
+}
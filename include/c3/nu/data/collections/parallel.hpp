@@ -0,0 +1,178 @@
+#pragma once
+
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "c3/nu/data.hpp"
+#include "c3/nu/data/collections/sequence.hpp"
+
+namespace c3::nu {
+  /// Below this many elements per thread, splitting a sequence costs more than it saves
+  constexpr size_t min_parallel_chunk = 4096;
+
+  namespace _parallel {
+    inline size_t n_chunks(size_t n_items, size_t n_threads) {
+      if (n_threads == 0)
+        n_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+      return std::max<size_t>(std::min(n_threads, n_items / min_parallel_chunk), 1);
+    }
+
+    /// Calls f(chunk, begin, end) for n_chunks even slices of [0, n_items), the first on this thread
+    ///
+    /// The first exception thrown by any chunk is rethrown once they have all finished. If threads run out,
+    /// the chunks that could not get one are run on this thread instead.
+    template<typename F>
+    inline void for_chunks(size_t n_items, size_t n_chunks, F&& f) {
+      std::vector<std::exception_ptr> errors(n_chunks);
+      auto run = [&](size_t chunk) {
+        try { f(chunk, n_items * chunk / n_chunks, n_items * (chunk + 1) / n_chunks); }
+        catch (...) { errors[chunk] = std::current_exception(); }
+      };
+
+      std::vector<std::thread> threads;
+      size_t spawned = 1;
+      try {
+        threads.reserve(n_chunks - 1);
+        for (; spawned < n_chunks; ++spawned)
+          threads.emplace_back(run, spawned);
+      }
+      // Nothing can throw past here until every thread is joined, as a joinable thread terminates on destruction
+      catch (...) {}
+
+      run(0);
+      for (size_t i = spawned; i < n_chunks; ++i)
+        run(i);
+      for (auto& i : threads)
+        i.join();
+
+      for (auto& i : errors)
+        if (i)
+          std::rethrow_exception(i);
+    }
+  }
+
+  /// As squash_seq, but split across n_threads threads (0 for one per core)
+  template<byte_order Order, typename Iter>
+  inline data squash_seq_par(Iter begin, Iter end, size_t n_threads = 0) {
+    using T = typename std::iterator_traits<Iter>::value_type;
+    using category = typename std::iterator_traits<Iter>::iterator_category;
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, category>,
+                  "Parallel squashing needs random access iterators");
+    static_assert(is_static_serialisable_v<T>, "Dynamically sized elements need a SizeType");
+
+    auto n = static_cast<size_t>(end - begin);
+    data ret(n * serialised_size<T>());
+
+    _parallel::for_chunks(n, _parallel::n_chunks(n, n_threads), [&](size_t, size_t first, size_t last) {
+      // Each chunk owns a fixed slice of the output, so no coordination is needed
+      span_sink sink{data_ref{ret}.subspan(first * serialised_size<T>(), (last - first) * serialised_size<T>())};
+      squash_seq_into<Order>(sink, begin + first, begin + last);
+    });
+
+    return ret;
+  }
+
+  template<typename Iter>
+  inline data squash_seq_par(Iter begin, Iter end, size_t n_threads = 0) {
+    return squash_seq_par<byte_order::big>(begin, end, n_threads);
+  }
+
+  /// As squash_seq<SizeType>, but split across n_threads threads (0 for one per core)
+  ///
+  /// Each chunk first sizes its own elements, and a prefix sum over those gives where each one writes
+  template<typename SizeType, byte_order Order, typename Iter>
+  inline data squash_seq_par(Iter begin, Iter end, size_t n_threads = 0) {
+    using T = typename std::iterator_traits<Iter>::value_type;
+    using category = typename std::iterator_traits<Iter>::iterator_category;
+    static_assert(std::is_base_of_v<std::random_access_iterator_tag, category>,
+                  "Parallel squashing needs random access iterators");
+    static_assert(!is_static_serialisable_v<T>, "Statically sized elements do not need a SizeType");
+
+    auto n = static_cast<size_t>(end - begin);
+    auto n_chunks = _parallel::n_chunks(n, n_threads);
+
+    std::vector<size_t> offsets(n_chunks + 1, 0);
+    _parallel::for_chunks(n, n_chunks, [&](size_t chunk, size_t first, size_t last) {
+      offsets[chunk + 1] = squashed_seq_size<SizeType>(begin + first, begin + last);
+    });
+    for (size_t i = 1; i < offsets.size(); ++i)
+      if (!integer_try_add(offsets[i], offsets[i - 1]))
+        throw serialisation_failure("Sequence size overflows size_t");
+
+    data ret(offsets.back());
+
+    _parallel::for_chunks(n, n_chunks, [&](size_t chunk, size_t first, size_t last) {
+      span_sink sink{data_ref{ret}.subspan(offsets[chunk], offsets[chunk + 1] - offsets[chunk])};
+      squash_seq_into<SizeType, Order>(sink, begin + first, begin + last);
+      if (sink.size() != offsets[chunk + 1] - offsets[chunk])
+        throw serialisation_failure("serialised_size_of disagreed with the serialised length");
+    });
+
+    return ret;
+  }
+
+  template<typename SizeType, typename Iter>
+  inline data squash_seq_par(Iter begin, Iter end, size_t n_threads = 0) {
+    return squash_seq_par<SizeType, byte_order::big>(begin, end, n_threads);
+  }
+
+  /// As expand_seq, but split across n_threads threads (0 for one per core)
+  template<typename T, byte_order Order>
+  inline std::vector<T> expand_seq_par(data_const_ref b, size_t n_threads = 0) {
+    static_assert(is_static_serialisable_v<T>, "Dynamically sized elements need a SizeType");
+
+    if (b.size() % serialised_size<T>() != 0)
+      throw serialisation_failure("Spare bits in serialised seq");
+
+    auto n = static_cast<size_t>(b.size()) / serialised_size<T>();
+    std::vector<T> ret(n);
+
+    _parallel::for_chunks(n, _parallel::n_chunks(n, n_threads), [&](size_t, size_t first, size_t last) {
+      auto in = b.subspan(first * serialised_size<T>(), (last - first) * serialised_size<T>());
+      if constexpr (is_bulk_serialisable_int_v<T>)
+        bulk_deserialise<T, Order>(in.data(), last - first, ret.data() + first);
+      else
+        for (size_t i = first; i < last; ++i, in = in.subspan(serialised_size<T>()))
+          ret[i] = deserialise<T, Order>(in.subspan(0, serialised_size<T>()));
+    });
+
+    return ret;
+  }
+
+  template<typename T>
+  inline std::vector<T> expand_seq_par(data_const_ref b, size_t n_threads = 0) {
+    return expand_seq_par<T, byte_order::big>(b, n_threads);
+  }
+
+  /// As expand_seq<T, SizeType>, but split across n_threads threads (0 for one per core)
+  ///
+  /// XXX: finding where each element starts means hopping along the prefixes on one thread first,
+  /// so only the deserialisation itself is parallel
+  template<typename T, typename SizeType, byte_order Order,
+           typename = typename std::enable_if<!is_static_serialisable_v<T>>::type>
+  inline std::vector<T> expand_seq_par(data_const_ref b, size_t n_threads = 0) {
+    std::vector<data_const_ref> elems;
+    while (b.size() > 0) {
+      size_t len = size_prefix<SizeType>::template read<Order>(b);
+      elems.push_back(b.subspan(0, len));
+      b = b.subspan(len);
+    }
+
+    std::vector<T> ret(elems.size());
+    _parallel::for_chunks(elems.size(), _parallel::n_chunks(elems.size(), n_threads),
+                          [&](size_t, size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i)
+        ret[i] = deserialise<T>(elems[i]);
+    });
+
+    return ret;
+  }
+
+  template<typename T, typename SizeType,
+           typename = typename std::enable_if<!is_static_serialisable_v<T>>::type>
+  inline std::vector<T> expand_seq_par(data_const_ref b, size_t n_threads = 0) {
+    return expand_seq_par<T, SizeType, byte_order::big>(b, n_threads);
+  }
+}
@@ -1,77 +1,320 @@
 #pragma once
 
 #include "c3/nu/data.hpp"
+#include "c3/nu/data/byteswap.hpp"
 #include "c3/nu/integer.hpp"
 
 namespace c3::nu {
-  template<typename Iter>
-  inline data squash_seq(Iter begin, Iter end) {
+  template<byte_order Order, typename Sink, typename Iter>
+  inline void squash_seq_into(Sink& s, Iter begin, Iter end) {
     using T = typename std::iterator_traits<Iter>::value_type;
+    using category = typename std::iterator_traits<Iter>::iterator_category;
+    static_assert(is_static_serialisable_v<T>, "Dynamically sized elements need a SizeType");
 
-    typename std::enable_if<is_static_serialisable_v<T>, data>::type ret;
+    if constexpr (is_bulk_serialisable_int_v<T> && is_contiguous_iter_v<Iter>) {
+      auto n = static_cast<size_t>(std::distance(begin, end));
+      if (n == 0)
+        return;
 
-    for (Iter iter = begin; iter != end; ++iter) {
-      auto& i = *iter;
+      data_ref out = s.claim(n * sizeof(T));
+      bulk_serialise_static<T, Order>(std::addressof(*begin), n, out.data());
+    }
+    else if constexpr (std::is_base_of_v<std::forward_iterator_tag, category>) {
+      // We know the whole size up front, so only grow the output once
+      auto n = static_cast<size_t>(std::distance(begin, end));
+      data_ref out = s.claim(n * serialised_size<T>());
 
-      auto pos = ret.size();
-      ret.resize(pos + serialised_size<T>());
-      serialise_static<T>(i, { ret.data() + pos, serialised_size<T>() });
-    };
+      auto* pos = out.data();
+      for (Iter iter = begin; iter != end; ++iter, pos += serialised_size<T>())
+        serialise_static<T, Order>(*iter, { pos, serialised_size<T>() });
+    }
+    else {
+      for (Iter iter = begin; iter != end; ++iter)
+        serialise_static<T, Order>(*iter, s.claim(serialised_size<T>()));
+    }
+  }
 
-    return ret;
+  template<typename Sink, typename Iter>
+  inline void squash_seq_into(Sink& s, Iter begin, Iter end) {
+    squash_seq_into<byte_order::big>(s, begin, end);
   }
 
+  /// The number of bytes squash_seq<SizeType> would produce
   template<typename SizeType, typename Iter>
-  inline data squash_seq(Iter begin, Iter end) {
+  inline size_t squashed_seq_size(Iter begin, Iter end) {
+    size_t ret = 0;
+    for (Iter iter = begin; iter != end; ++iter)
+      if (!integer_try_add(ret, serialised_size_prefixed<SizeType>(*iter)))
+        throw serialisation_failure("Sequence size overflows size_t");
+    return ret;
+  }
+
+  template<typename SizeType, byte_order Order, typename Sink, typename Iter>
+  inline void squash_seq_into(Sink& s, Iter begin, Iter end) {
     using T = typename std::iterator_traits<Iter>::value_type;
+    using category = typename std::iterator_traits<Iter>::iterator_category;
+    static_assert(!is_static_serialisable_v<T>, "Statically sized elements do not need a SizeType");
 
-    typename std::enable_if<!is_static_serialisable_v<T>, data>::type ret;
+    // Sizing elements that can only be sized by serialising them would serialise them twice
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, category> && knows_serialised_size_v<T>)
+      s.reserve(squashed_seq_size<SizeType>(begin, end));
 
-    for (Iter iter = begin; iter != end; ++iter) {
-      auto& i = *iter;
+    for (Iter iter = begin; iter != end; ++iter)
+      serialise_into_prefixed<SizeType, Order>(*iter, s);
+  }
 
-      data buf = serialise(i);
+  template<typename SizeType, typename Sink, typename Iter>
+  inline void squash_seq_into(Sink& s, Iter begin, Iter end) {
+    squash_seq_into<SizeType, byte_order::big>(s, begin, end);
+  }
 
-      {
-        SizeType len_s = buf.size();
-        auto pos = ret.size();
-        ret.resize(pos + serialised_size<SizeType>());
-        serialise_static<SizeType>(len_s, { ret.data() + pos, serialised_size<SizeType>() });
-      }
+  template<byte_order Order, typename Iter>
+  inline data squash_seq(Iter begin, Iter end) {
+    using T = typename std::iterator_traits<Iter>::value_type;
 
-      ret.insert(ret.end(), buf.begin(), buf.end());
-    }
+    typename std::enable_if<is_static_serialisable_v<T>, data>::type ret;
+    data_sink sink{ret};
+    squash_seq_into<Order>(sink, begin, end);
+    return ret;
+  }
 
+  template<typename Iter>
+  inline data squash_seq(Iter begin, Iter end) {
+    return squash_seq<byte_order::big>(begin, end);
+  }
+
+  template<typename SizeType, byte_order Order, typename Iter>
+  inline data squash_seq(Iter begin, Iter end) {
+    using T = typename std::iterator_traits<Iter>::value_type;
+
+    typename std::enable_if<!is_static_serialisable_v<T>, data>::type ret;
+    data_sink sink{ret};
+    squash_seq_into<SizeType, Order>(sink, begin, end);
     return ret;
   }
 
-  template<typename T>
+  template<typename SizeType, typename Iter>
+  inline data squash_seq(Iter begin, Iter end) {
+    return squash_seq<SizeType, byte_order::big>(begin, end);
+  }
+
+  template<typename T, byte_order Order, validation V = validation::checked>
   inline std::vector<T> expand_seq(nu::data_const_ref b) {
     std::vector<typename std::enable_if<is_static_serialisable_v<T>, T>::type> ret;
 
     if (b.size() % serialised_size<T>() != 0)
       throw serialisation_failure("Spare bits in serialised seq");
 
-    for (size_t i = 0; i < static_cast<size_t>(b.size()); i += serialised_size<T>())
-      ret.emplace_back(deserialise<T>(b.subspan(i, serialised_size<T>())));
+    size_t n = static_cast<size_t>(b.size()) / serialised_size<T>();
+
+    if constexpr (is_bulk_serialisable_int_v<T>) {
+      ret.resize(n);
+      bulk_deserialise<T, Order>(b.data(), n, ret.data());
+    }
+    else if constexpr (V == validation::validate_once) {
+      // The size check above covers every element
+      ret.reserve(n);
+      const uint8_t* pos = b.data();
+      for (size_t i = 0; i < n; ++i, pos += serialised_size<T>())
+        ret.emplace_back(deserialise_unchecked<T, Order>(pos));
+    }
+    else {
+      ret.reserve(n);
+      for (size_t i = 0; i < static_cast<size_t>(b.size()); i += serialised_size<T>())
+        ret.emplace_back(deserialise<T, Order>(b.subspan(i, serialised_size<T>())));
+    }
 
     return ret;
   }
 
-  template<typename T, typename SizeType,
+  template<typename T>
+  inline std::vector<T> expand_seq(nu::data_const_ref b) {
+    return expand_seq<T, byte_order::big>(b);
+  }
+
+  template<typename T, validation V>
+  inline std::vector<T> expand_seq(nu::data_const_ref b) {
+    return expand_seq<T, byte_order::big, V>(b);
+  }
+
+  template<typename T, typename SizeType, byte_order Order, validation V = validation::checked,
            typename = typename std::enable_if<!is_static_serialisable_v<T>>::type>
   inline std::vector<T> expand_seq(nu::data_const_ref b) {
     std::vector<T> ret;
 
-    while (b.size() > 0) {
-      SizeType len_s = deserialise<SizeType>(b.subspan(0, serialised_size<SizeType>()));
-      if (!integer_can_hold<size_t>(len_s))
-        throw serialisation_failure("Element size overflows size_t");
-      size_t len = len_s;
-      ret.emplace_back(deserialise<T>(b.subspan(serialised_size<SizeType>(), len)));
-      b = b.subspan(serialised_size<SizeType>() + len);
+    if constexpr (V == validation::validate_once) {
+      // Walk the prefixes once to check the framing, which also gives the count up front
+      size_t n = 0;
+      for (data_const_ref rest = b; rest.size() > 0; ++n) {
+        size_t len = size_prefix<SizeType>::template read<Order>(rest);
+        if (len > static_cast<size_t>(rest.size()))
+          throw serialisation_failure("Sequence element overruns buffer");
+        rest = rest.subspan(static_cast<data_const_ref::index_type>(len));
+      }
+
+      ret.reserve(n);
+      const uint8_t* pos = b.data();
+      for (size_t i = 0; i < n; ++i) {
+        size_t len = size_prefix<SizeType>::template read_unchecked<Order>(pos);
+        ret.emplace_back(deserialise<T>(data_const_ref{pos, static_cast<data_const_ref::index_type>(len)}));
+        pos += len;
+      }
+    }
+    else {
+      while (b.size() > 0) {
+        size_t len = size_prefix<SizeType>::template read<Order>(b);
+        ret.emplace_back(deserialise<T>(b.subspan(0, len)));
+        b = b.subspan(len);
+      }
     }
 
     return ret;
   }
+
+  template<typename T, typename SizeType,
+           typename = typename std::enable_if<!is_static_serialisable_v<T>>::type>
+  inline std::vector<T> expand_seq(nu::data_const_ref b) {
+    return expand_seq<T, SizeType, byte_order::big>(b);
+  }
+
+  template<typename T, typename SizeType, validation V,
+           typename = typename std::enable_if<!is_static_serialisable_v<T>>::type>
+  inline std::vector<T> expand_seq(nu::data_const_ref b) {
+    return expand_seq<T, SizeType, byte_order::big, V>(b);
+  }
+
+  /// A borrowed view over a sequence produced by squash_seq, deserialising elements as they are accessed
+  ///
+  /// With a borrowing element type (such as std::string_view or data_const_ref) nothing is copied,
+  /// so the view must not outlive the buffer it was made from.
+  ///
+  /// The SizeType must be given for dynamically sized elements, as with expand_seq
+  template<typename T, typename SizeType = void>
+  class seq_view : public serialisable<seq_view<T, SizeType>> {
+    friend serialisable<seq_view<T, SizeType>>;
+    template<typename U>
+    friend U deserialise(data_const_ref);
+    template<typename U, typename Sink>
+    friend void serialise_into(const U&, Sink&);
+    template<typename U>
+    friend constexpr size_t serialised_size_of(const U&);
+
+  public:
+    static constexpr bool is_static = is_static_serialisable_v<T>;
+    static_assert(is_static == std::is_void_v<SizeType>,
+                  "A SizeType must be given iff the elements are dynamically sized");
+
+  private:
+    data_const_ref _buf;
+    size_t _size = 0;
+
+  private:
+    /// Splits the next element off the front of b
+    static inline data_const_ref _next(data_const_ref& b) {
+      if constexpr (is_static) {
+        auto ret = b.subspan(0, serialised_size<T>());
+        b = b.subspan(serialised_size<T>());
+        return ret;
+      }
+      else {
+        size_t len = size_prefix<SizeType>::read(b);
+        auto ret = b.subspan(0, len);
+        b = b.subspan(len);
+        return ret;
+      }
+    }
+
+  public:
+    class iterator {
+      friend seq_view;
+
+    private:
+      data_const_ref _rest;
+      data_const_ref _current;
+
+    private:
+      inline void load() {
+        if (_rest.size() > 0)
+          _current = _next(_rest);
+        else
+          // Null out both, so that we compare equal to end()
+          _rest = _current = {};
+      }
+      inline iterator(data_const_ref b) : _rest{b} { load(); }
+
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = T;
+
+    public:
+      inline T operator*() const { return deserialise<T>(_current); }
+      /// The serialised form of the current element, without deserialising it
+      inline data_const_ref raw() const { return _current; }
+
+      inline iterator& operator++() { load(); return *this; }
+      inline iterator operator++(int) { auto cpy = *this; load(); return cpy; }
+
+      inline bool operator==(const iterator& other) const { return _rest.data() == other._rest.data(); }
+      inline bool operator!=(const iterator& other) const { return !(*this == other); }
+
+    public:
+      inline iterator() = default;
+    };
+
+  public:
+    inline size_t size() const { return _size; }
+    inline bool empty() const { return _size == 0; }
+    inline data_const_ref raw() const { return _buf; }
+
+    inline iterator begin() const { return { _buf }; }
+    inline iterator end() const { return {}; }
+
+    template<typename U = T>
+    inline typename std::enable_if<is_static_serialisable_v<U>, T>::type operator[](size_t i) const {
+      return deserialise<T>(_buf.subspan(i * serialised_size<T>(), serialised_size<T>()));
+    }
+
+    /// Copies the elements out into a vector
+    inline std::vector<T> to_vector() const {
+      if constexpr (is_static)
+        return expand_seq<T>(_buf);
+      else {
+        std::vector<T> ret;
+        ret.reserve(_size);
+        for (auto i : *this)
+          ret.emplace_back(std::move(i));
+        return ret;
+      }
+    }
+
+  private:
+    inline data _serialise() const override { return { _buf.begin(), _buf.end() }; }
+
+    template<typename Sink>
+    inline void _serialise_into(Sink& s) const { s.append_borrowed(_buf); }
+    inline size_t _serialised_size_of() const { return static_cast<size_t>(_buf.size()); }
+
+    static inline seq_view _deserialise(data_const_ref b) { return { b }; }
+
+  public:
+    inline seq_view() = default;
+    /// Checks the framing of every element up front, so that iteration cannot fail part way through
+    inline seq_view(data_const_ref b) : _buf{b} {
+      if constexpr (is_static) {
+        if (b.size() % serialised_size<T>() != 0)
+          throw serialisation_failure("Spare bits in serialised seq");
+        _size = static_cast<size_t>(b.size()) / serialised_size<T>();
+      }
+      else {
+        for (; b.size() > 0; ++_size)
+          _next(b);
+      }
+    }
+  };
+
+  template<typename T, typename SizeType>
+  struct borrows_from_input<seq_view<T, SizeType>> : std::true_type {};
 }
@@ -3,38 +3,84 @@
 #include "c3/nu/data.hpp"
 
 namespace c3::nu {
+  template<byte_order Order>
   inline void squash_static_unsafe(data_ref) {}
 
-  template<typename Head, typename... Tail>
+  template<byte_order Order, typename Head, typename... Tail>
   inline void squash_static_unsafe(data_ref b, Head&& head, Tail&&... tail) {
-    auto len = nu::serialised_size<typename remove_all<Head>::type>();
-    serialise_static(head, {b.data(), static_cast<data_ref::size_type>(len)});
+    using head_t = typename remove_all<Head>::type;
+    auto len = nu::serialised_size<head_t>();
+    serialise_static<head_t, Order>(head, {b.data(), static_cast<data_ref::size_type>(len)});
     if constexpr (sizeof...(Tail) > 0)
-      squash_static_unsafe({b.data() + len, static_cast<data_ref::size_type>(b.size() - len)},
-                           std::forward<Tail&&>(tail)...);
+      squash_static_unsafe<Order>({b.data() + len, static_cast<data_ref::size_type>(b.size() - len)},
+                                  std::forward<Tail&&>(tail)...);
   }
 
-  template<typename... Input>
+  inline void squash_static_unsafe(data_ref) {}
+
+  template<typename Head, typename... Tail>
+  inline void squash_static_unsafe(data_ref b, Head&& head, Tail&&... tail) {
+    squash_static_unsafe<byte_order::big>(b, std::forward<Head&&>(head), std::forward<Tail&&>(tail)...);
+  }
+
+  template<byte_order Order, typename... Input>
   inline data squash_static(Input&&... in) {
     data ret(total_serialised_size<Input...>());
-    squash_static_unsafe(ret, in...);
+    squash_static_unsafe<Order>(ret, in...);
     return ret;
   }
 
-  template<typename Head, typename... Tail>
+  template<typename... Input>
+  inline data squash_static(Input&&... in) {
+    return squash_static<byte_order::big>(in...);
+  }
+
+  template<byte_order Order, typename Sink, typename... Input>
+  inline void squash_static_into(Sink& s, Input&&... in) {
+    squash_static_unsafe<Order>(s.claim(total_serialised_size<Input...>()), in...);
+  }
+
+  template<typename Sink, typename... Input>
+  inline void squash_static_into(Sink& s, Input&&... in) {
+    squash_static_into<byte_order::big>(s, in...);
+  }
+
+  template<byte_order Order, typename Head, typename... Tail>
   inline void expand_static_unsafe(data_const_ref b, Head& head, Tail&... tail) {
     constexpr auto len = serialised_size<Head>();
-    head = deserialise<Head>(b.subspan(0, len));
+    head = deserialise<Head, Order>(b.subspan(0, len));
     if constexpr (sizeof...(Tail) > 0) {
-      expand_static_unsafe({b.data() + len, static_cast<data_ref::size_type>(b.size() - len)},
-                           tail...);
+      expand_static_unsafe<Order>({b.data() + len, static_cast<data_ref::size_type>(b.size() - len)},
+                                  tail...);
     }
   }
 
-  template<typename... Output>
+  template<typename Head, typename... Tail>
+  inline void expand_static_unsafe(data_const_ref b, Head& head, Tail&... tail) {
+    expand_static_unsafe<byte_order::big>(b, head, tail...);
+  }
+
+  template<byte_order Order, validation V = validation::checked, typename... Output>
   inline void expand_static(data_const_ref b, Output&... output) {
     if (total_serialised_size<Output...>() != static_cast<size_t>(b.size()))
       throw std::range_error("Expanding would overrun buffer");
-    expand_static_unsafe(b, output...);
+
+    if constexpr (V == validation::validate_once) {
+      // The one size check above covers every field
+      const uint8_t* pos = b.data();
+      ((output = deserialise_unchecked<Output, Order>(pos), pos += serialised_size<Output>()), ...);
+    }
+    else
+      expand_static_unsafe<Order>(b, output...);
+  }
+
+  template<validation V, typename... Output>
+  inline void expand_static(data_const_ref b, Output&... output) {
+    expand_static<byte_order::big, V>(b, output...);
+  }
+
+  template<typename... Output>
+  inline void expand_static(data_const_ref b, Output&... output) {
+    expand_static<byte_order::big>(b, output...);
   }
 }
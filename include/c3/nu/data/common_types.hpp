@@ -49,6 +49,34 @@ namespace c3::nu {
   inline std::string deserialise(data_const_ref b) {
     return { b.begin(), b.end() };
   }
+  template<typename Sink>
+  inline void serialise_into(const std::string& str, Sink& s) {
+    s.append_borrowed({ reinterpret_cast<const uint8_t*>(str.data()),
+               static_cast<data_const_ref::size_type>(str.size()) });
+  }
+  inline size_t serialised_size_of(const std::string& str) { return str.size(); }
+  template<>
+  struct knows_serialised_size<std::string> : std::true_type {};
+
+  template<>
+  inline data serialise(const std::string_view& str) {
+    return { str.begin(), str.end() };
+  }
+  /// Borrows from b, so must not outlive it
+  template<>
+  inline std::string_view deserialise(data_const_ref b) {
+    return { reinterpret_cast<const char*>(b.data()), static_cast<size_t>(b.size()) };
+  }
+  template<>
+  struct borrows_from_input<std::string_view> : std::true_type {};
+  template<typename Sink>
+  inline void serialise_into(const std::string_view& str, Sink& s) {
+    s.append_borrowed({ reinterpret_cast<const uint8_t*>(str.data()),
+               static_cast<data_const_ref::size_type>(str.size()) });
+  }
+  inline size_t serialised_size_of(const std::string_view& str) { return str.size(); }
+  template<>
+  struct knows_serialised_size<std::string_view> : std::true_type {};
 
   template<>
   constexpr size_t serialised_size<uint8_t>() { return 1; }
@@ -93,13 +121,33 @@ namespace c3::nu {
   inline data serialise(const data& b) { return b; }
   template<>
   inline data deserialise(data_const_ref b) { return data(b.begin(), b.end()); }
+  template<typename Sink>
+  inline void serialise_into(const data& b, Sink& s) { s.append_borrowed(b); }
+  inline size_t serialised_size_of(const data& b) { return b.size(); }
+  template<>
+  struct knows_serialised_size<data> : std::true_type {};
 
   template<>
   inline data serialise(const data_const_ref& b) { return data(b.begin(), b.end()); }
   template<>
   inline data_const_ref deserialise(data_const_ref b) { return b; }
+  template<>
+  struct borrows_from_input<data_const_ref> : std::true_type {};
+  template<typename Sink>
+  inline void serialise_into(const data_const_ref& b, Sink& s) { s.append_borrowed(b); }
+  inline size_t serialised_size_of(const data_const_ref& b) { return static_cast<size_t>(b.size()); }
+  template<>
+  struct knows_serialised_size<data_const_ref> : std::true_type {};
 
   inline data serialise(const char* cstr) {
     return { cstr, cstr + ::strlen(cstr) };
   }
+  template<typename Sink>
+  inline void serialise_into(const char* cstr, Sink& s) {
+    s.append_borrowed({ reinterpret_cast<const uint8_t*>(cstr),
+               static_cast<data_const_ref::size_type>(::strlen(cstr)) });
+  }
+  inline size_t serialised_size_of(const char* cstr) { return ::strlen(cstr); }
+  template<>
+  struct knows_serialised_size<const char*> : std::true_type {};
 }
@@ -47,14 +47,26 @@ namespace c3::nu {
     return 3 * (sextets / 4) - padding_len;
   }
 
-  inline std::string base64_encode_data(data_const_ref b) {
-    std::string ret(base64_encoded_len(b.size()), '=');
+  template<typename String>
+  inline void _base64_encode_data_into(data_const_ref b, String& ret) {
+    ret.assign(base64_encoded_len(b.size()), '=');
 
-    bits_const_ref bits{b};
+    bit_reader bits{b};
 
     for (size_t i = 0; i < base64_encoded_unpadded_len(b.size()); ++i)
-      ret[i] = base64_encode_lookup_table[bits.get_datum<6>(i * 6).get()];
+      ret[i] = base64_encode_lookup_table[bits.read<6>().get()];
+  }
+
+  inline std::string base64_encode_data(data_const_ref b) {
+    std::string ret;
+    _base64_encode_data_into(b, ret);
+    return ret;
+  }
 
+  /// As base64_encode_data, but allocating the output from mr
+  inline std::pmr::string base64_encode_data(data_const_ref b, std::pmr::memory_resource* mr) {
+    std::pmr::string ret{mr};
+    _base64_encode_data_into(b, ret);
     return ret;
   }
 
@@ -71,13 +83,14 @@ namespace c3::nu {
 
     data ret(base64_decoded_len(str.size(), padding_len));
 
-    bits_ref bits{data_ref{ret}};
+    bit_writer bits{data_ref{ret}};
 
     for (size_t i = 0; i < str.size() - padding_len; ++i) {
       if (std::isspace(str[i]))
         continue;
-      bits.set_datum(i * 6, base64_decode_lookup_table[str[i]].value());
+      bits.write(base64_decode_lookup_table[str[i]].value());
     }
+    bits.flush();
 
     return ret;
   }
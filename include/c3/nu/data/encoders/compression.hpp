@@ -0,0 +1,427 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include "c3/nu/data.hpp"
+
+// An LZ4-style block compressor, trading ratio for speed.
+//
+// A block is a series of sequences, each being:
+//
+//   token     the literal length (high nibble) and match length less 4 (low nibble), 15 meaning more follow
+//   literals  the literal length, continued as bytes of 255 until one is smaller, then that many bytes
+//   offset    how far back the match starts, as a little-endian uint16_t
+//   match     the match length, continued as for the literals
+//
+// The final sequence has only literals. Apart from the leading size, compress_data's output is therefore
+// a plain LZ4 block.
+
+namespace c3::nu {
+  namespace _compression {
+    constexpr size_t min_match = 4;
+    /// The final bytes are always literals, so that matches never need to check for the end
+    constexpr size_t last_literals = 5;
+    /// No match starts in the final bytes of the input
+    constexpr size_t match_limit = 12;
+    constexpr size_t max_offset = 65535;
+    constexpr unsigned hash_bits = 12;
+
+    inline uint32_t read32(const uint8_t* p) {
+      uint32_t ret;
+      std::memcpy(&ret, p, sizeof(ret));
+      return ret;
+    }
+
+    inline uint32_t hash(uint32_t i) {
+      return (i * 2654435761u) >> (32 - hash_bits);
+    }
+
+    inline uint8_t* write_len(uint8_t* out, size_t len) {
+      for (; len >= 255; len -= 255)
+        *out++ = 255;
+      *out++ = static_cast<uint8_t>(len);
+      return out;
+    }
+
+    inline uint8_t* write_sequence(uint8_t* out, const uint8_t* literals, size_t n_literals,
+                                   size_t offset, size_t match_len) {
+      uint8_t* token = out++;
+      *token = static_cast<uint8_t>(std::min<size_t>(n_literals, 15) << 4);
+      if (n_literals >= 15)
+        out = write_len(out, n_literals - 15);
+      // Empty input may have no buffer at all, which memcpy does not allow even for no bytes
+      if (n_literals != 0)
+        std::memcpy(out, literals, n_literals);
+      out += n_literals;
+
+      // The final sequence has no match
+      if (match_len == 0)
+        return out;
+
+      *out++ = static_cast<uint8_t>(offset);
+      *out++ = static_cast<uint8_t>(offset >> 8);
+      match_len -= min_match;
+      *token |= static_cast<uint8_t>(std::min<size_t>(match_len, 15));
+      if (match_len >= 15)
+        out = write_len(out, match_len - 15);
+      return out;
+    }
+
+    /// Reads a continued length, checking that it neither overruns the input nor overflows
+    inline size_t read_len(const uint8_t*& in, const uint8_t* in_end, size_t len) {
+      if (len != 15)
+        return len;
+
+      uint8_t next;
+      do {
+        if (in == in_end)
+          throw serialisation_failure("Truncated compressed block");
+        next = *in++;
+        if (!integer_try_add(len, size_t{next}))
+          throw serialisation_failure("Compressed length overflows size_t");
+      } while (next == 255);
+
+      return len;
+    }
+  }
+
+  /// The most bytes compress_block can produce from n
+  constexpr size_t compress_block_bound(size_t n) {
+    return n + n / 255 + 16;
+  }
+
+  /// Compresses in onto the end of out
+  inline void compress_block(data_const_ref in, data& out) {
+    using namespace _compression;
+
+    const uint8_t* base = in.data();
+    size_t n = static_cast<size_t>(in.size());
+
+    auto out_start = out.size();
+    out.resize(out_start + compress_block_bound(n));
+    uint8_t* op = out.data() + out_start;
+
+    size_t anchor = 0;
+    if (n > match_limit) {
+      // Positions of earlier 4 byte runs, by hash. A stale or colliding entry is caught by checking it
+      std::array<uint32_t, 1 << hash_bits> table{};
+      size_t ip = 1;
+      // Give up on incompressible data quickly, by stepping further the longer we go without a match
+      size_t misses = 0;
+
+      while (ip < n - match_limit) {
+        auto seq = read32(base + ip);
+        auto& slot = table[hash(seq)];
+        size_t ref = slot;
+        slot = static_cast<uint32_t>(ip);
+
+        if (ref >= ip || ip - ref > max_offset || read32(base + ref) != seq) {
+          ip += 1 + (misses++ >> 6);
+          continue;
+        }
+        misses = 0;
+
+        // Grow the match back into the literals, and then forwards as far as allowed
+        while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1]) {
+          --ip;
+          --ref;
+        }
+        size_t len = min_match;
+        while (ip + len < n - last_literals && base[ip + len] == base[ref + len])
+          ++len;
+
+        op = write_sequence(op, base + anchor, ip - anchor, ip - ref, len);
+        ip += len;
+        anchor = ip;
+
+        // Seed the table from inside the match, which helps with runs
+        if (ip < n - match_limit)
+          table[hash(read32(base + ip - 2))] = static_cast<uint32_t>(ip - 2);
+      }
+    }
+
+    op = write_sequence(op, base + anchor, n - anchor, 0, 0);
+    out.resize(static_cast<size_t>(op - out.data()));
+  }
+
+  /// Decompresses in into out, which must be exactly the size of the original
+  ///
+  /// Every length and offset is checked, so malformed input throws rather than reading or writing out of bounds
+  inline void decompress_block(data_const_ref in, data_ref out) {
+    using namespace _compression;
+
+    const uint8_t* ip = in.data();
+    const uint8_t* in_end = ip + in.size();
+    uint8_t* op = out.data();
+    uint8_t* out_start = op;
+    uint8_t* out_end = op + out.size();
+
+    while (true) {
+      if (ip == in_end)
+        throw serialisation_failure("Truncated compressed block");
+      auto token = *ip++;
+
+      auto n_literals = read_len(ip, in_end, token >> 4);
+      if (n_literals > static_cast<size_t>(in_end - ip) || n_literals > static_cast<size_t>(out_end - op))
+        throw serialisation_failure("Compressed literals overrun buffer");
+      if (n_literals != 0)
+        std::memcpy(op, ip, n_literals);
+      ip += n_literals;
+      op += n_literals;
+
+      // Only the final sequence ends the input
+      if (ip == in_end)
+        break;
+
+      if (in_end - ip < 2)
+        throw serialisation_failure("Truncated compressed block");
+      size_t offset = ip[0] | (size_t{ip[1]} << 8);
+      ip += 2;
+      if (offset == 0 || offset > static_cast<size_t>(op - out_start))
+        throw serialisation_failure("Compressed match offset out of range");
+
+      auto match_len = read_len(ip, in_end, token & 15);
+      if (!integer_try_add(match_len, min_match) || match_len > static_cast<size_t>(out_end - op))
+        throw serialisation_failure("Compressed match overruns buffer");
+
+      const uint8_t* match = op - offset;
+      if (offset >= match_len)
+        std::memcpy(op, match, match_len);
+      else
+        // Overlapping matches repeat the last offset bytes
+        for (size_t i = 0; i < match_len; ++i)
+          op[i] = match[i];
+      op += match_len;
+    }
+
+    if (op != out_end)
+      throw serialisation_failure("Compressed block has the wrong length");
+  }
+
+  /// Compresses b, prefixed with its original size as a varint
+  inline data compress_data(data_const_ref b) {
+    auto len = static_cast<size_t>(b.size());
+
+    data ret(varint_len(len));
+    encode_varint(len, ret.data());
+    compress_block(b, ret);
+    return ret;
+  }
+
+  inline data decompress_data(data_const_ref b) {
+    auto len = decode_varint(b);
+    // Every byte of a block can expand to at most 255, so this guards against huge bogus sizes
+    if (len / 255 > static_cast<uint64_t>(b.size()))
+      throw serialisation_failure("Compressed size is implausibly large");
+
+    data ret(static_cast<size_t>(len));
+    decompress_block(b, ret);
+    return ret;
+  }
+
+  template<typename T>
+  inline data compress(const T& t) {
+    return compress_data(serialise(t));
+  }
+
+  template<typename T>
+  inline T decompress(data_const_ref b) {
+    return deserialise<T>(decompress_data(b));
+  }
+
+  // A compressed stream is a series of chunks, each being:
+  //
+  //   raw_len     the decompressed length, as a varint. 0 ends the stream
+  //   stored_len  the length of the chunk body shifted left one, with the low bit set if it is stored
+  //               uncompressed, as a varint
+  //   body        the compressed block, or the raw bytes
+
+  /// The most bytes in a single chunk of a compressed stream
+  constexpr size_t compressed_chunk_size = 64 * 1024;
+
+  /// A sink that compresses everything written to it onto another sink, a chunk at a time
+  ///
+  /// finish() must be called once everything has been written, to flush the final chunk and end the stream
+  template<typename Sink>
+  class compress_sink {
+  private:
+    Sink& _inner;
+    data _buf;
+    data _compressed;
+    size_t _size = 0;
+    bool _finished = false;
+
+  private:
+    inline void _write_chunk(data_const_ref chunk) {
+      _compressed.clear();
+      compress_block(chunk, _compressed);
+
+      bool stored = _compressed.size() >= static_cast<size_t>(chunk.size());
+      auto body = stored ? chunk : data_const_ref{_compressed};
+      auto raw_len = static_cast<size_t>(chunk.size());
+      auto stored_len = (static_cast<size_t>(body.size()) << 1) | (stored ? 1 : 0);
+
+      _inner.reserve(varint_len(raw_len) + varint_len(stored_len) + static_cast<size_t>(body.size()));
+      encode_varint(raw_len, _inner.claim(varint_len(raw_len)).data());
+      encode_varint(stored_len, _inner.claim(varint_len(stored_len)).data());
+      _inner.append(body);
+    }
+
+    /// Compresses every whole chunk in the buffer
+    ///
+    /// This only happens on the next call after a claim, once the caller has filled it in
+    inline void _flush_full() {
+      size_t pos = 0;
+      for (; _buf.size() - pos >= compressed_chunk_size; pos += compressed_chunk_size)
+        _write_chunk(data_const_ref{_buf}.subspan(pos, compressed_chunk_size));
+      _buf.erase(_buf.begin(), _buf.begin() + static_cast<ssize_t>(pos));
+    }
+
+  public:
+    inline size_t size() const { return _size; }
+
+    inline void reserve(size_t) {}
+
+    inline data_ref claim(size_t n) {
+      if (_finished)
+        throw std::logic_error("Compressed stream already finished");
+
+      _flush_full();
+      auto pos = _buf.size();
+      _buf.resize(pos + n);
+      _size += n;
+      return { _buf.data() + pos, static_cast<data_ref::size_type>(n) };
+    }
+
+    inline void append(data_const_ref b) {
+      auto to_fill = claim(static_cast<size_t>(b.size()));
+      std::copy(b.begin(), b.end(), to_fill.begin());
+    }
+    inline void append_borrowed(data_const_ref b) { append(b); }
+
+    /// Flushes what is left and ends the stream
+    inline void finish() {
+      if (_finished)
+        return;
+
+      _flush_full();
+      if (!_buf.empty())
+        _write_chunk(_buf);
+      _buf.clear();
+      *_inner.claim(1).data() = 0;
+      _finished = true;
+    }
+
+  public:
+    inline compress_sink(Sink& inner) : _inner{inner} {}
+  };
+
+  /// Decompresses a compressed stream that arrives in pieces of any size
+  class decompressor {
+  private:
+    data _pending;
+    size_t _pending_pos = 0;
+    data _out;
+    bool _done = false;
+
+  private:
+    static inline bool _has_varint(data_const_ref b) {
+      // Anything this long is either complete or malformed, and decode_varint will say which
+      return !b.empty() && (static_cast<size_t>(b.size()) >= varint_max_len ||
+                            !std::all_of(b.begin(), b.end(), [](uint8_t i) { return i & 0x80; }));
+    }
+
+    /// Decodes the next whole chunk from the pending input, returning false if it has not all arrived
+    inline bool _step() {
+      data_const_ref b = data_const_ref{_pending}.subspan(_pending_pos);
+      auto start = b.data();
+
+      if (!_has_varint(b))
+        return false;
+      auto raw_len = decode_varint(b);
+      if (raw_len == 0) {
+        _done = true;
+        _pending_pos += static_cast<size_t>(b.data() - start);
+        return false;
+      }
+      if (raw_len > compressed_chunk_size)
+        throw serialisation_failure("Compressed chunk too large");
+
+      if (!_has_varint(b))
+        return false;
+      auto stored_len = decode_varint(b);
+      bool stored = stored_len & 1;
+      stored_len >>= 1;
+      if (stored_len > compress_block_bound(compressed_chunk_size) || (stored && stored_len != raw_len))
+        throw serialisation_failure("Corrupt compressed chunk header");
+      if (stored_len > static_cast<uint64_t>(b.size()))
+        return false;
+
+      auto body = b.subspan(0, static_cast<data_const_ref::index_type>(stored_len));
+      auto pos = _out.size();
+      _out.resize(pos + static_cast<size_t>(raw_len));
+      if (stored)
+        std::copy(body.begin(), body.end(), _out.begin() + static_cast<ssize_t>(pos));
+      else
+        decompress_block(body, data_ref{_out}.subspan(static_cast<data_ref::index_type>(pos)));
+
+      _pending_pos += static_cast<size_t>(body.data() + body.size() - start);
+      return true;
+    }
+
+  public:
+    /// Adds more of the stream, decompressing every chunk that is now complete
+    inline void feed(data_const_ref b) {
+      if (_done) {
+        if (!b.empty())
+          throw serialisation_failure("Data after the end of a compressed stream");
+        return;
+      }
+
+      _pending.insert(_pending.end(), b.begin(), b.end());
+      while (!_done && _step());
+
+      // Only the partial chunk at the end is kept
+      _pending.erase(_pending.begin(), _pending.begin() + static_cast<ssize_t>(_pending_pos));
+      _pending_pos = 0;
+      if (_done && !_pending.empty())
+        throw serialisation_failure("Data after the end of a compressed stream");
+    }
+
+    /// Whether the end of the stream has been reached
+    inline bool done() const { return _done; }
+
+    /// Everything decompressed since the last take
+    inline data take() {
+      data ret;
+      ret.swap(_out);
+      return ret;
+    }
+
+    /// Takes everything, and checks that the stream really ended
+    inline data finish() {
+      if (!_done)
+        throw serialisation_failure("Compressed stream ended early");
+      return take();
+    }
+  };
+
+  /// Compresses b as a stream, all in one go
+  inline data compress_stream(data_const_ref b) {
+    data ret;
+    data_sink sink{ret};
+    compress_sink<data_sink> cs{sink};
+    cs.append(b);
+    cs.finish();
+    return ret;
+  }
+
+  inline data decompress_stream(data_const_ref b) {
+    decompressor d;
+    d.feed(b);
+    return d.finish();
+  }
+}
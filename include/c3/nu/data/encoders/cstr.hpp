@@ -25,12 +25,14 @@ namespace c3::nu {
         case (' '): ret.push_back(' '); break;
 
         default: {
-          if (std::isprint(i))
+          // As unsigned, so that high bytes are not sign extended
+          auto u = static_cast<unsigned char>(i);
+          if (std::isprint(u))
             ret.push_back(i);
           else {
             ret.push_back('\\');
             char a[4] = { 0 };
-            sprintf(a, "%03o", i);
+            sprintf(a, "%03o", u);
             ret.append(a);
           }
         }
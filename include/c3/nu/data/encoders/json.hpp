@@ -48,7 +48,8 @@ namespace c3::nu {
     }, t);
   }
 
-  inline void _json_encode_impl(const obj_struct& ds, std::string& acc) {
+  template<typename String>
+  inline void _json_encode_impl(const obj_struct& ds, String& acc) {
     if (ds.is_parent()) {
       acc.push_back('{');
       auto iter = ds.begin();
@@ -76,6 +77,14 @@ namespace c3::nu {
     _json_encode_impl(ds, ret);
     return ret;
   }
+  /// As json_encode, but building the output in mr
+  ///
+  /// XXX: escaped strings and leaf values are still built in short-lived std::strings first
+  inline std::pmr::string json_encode(const obj_struct& ds, std::pmr::memory_resource* mr) {
+    std::pmr::string ret{mr};
+    _json_encode_impl(ds, ret);
+    return ret;
+  }
   inline bool _is_json_delim(char c) {
     return c == ',' || std::isspace(c);
   }
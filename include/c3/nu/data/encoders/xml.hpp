@@ -97,7 +97,8 @@ namespace c3::nu {
   }
 
   namespace detail {
-    inline void xml_encode_impl(const markup_struct& ms, std::string& str) {
+    template<typename String>
+    inline void xml_encode_impl(const markup_struct& ms, String& str) {
       str.push_back('<');
       if (!xml_verify_name(ms.type))
         throw std::runtime_error("Invalid name for XML element");
@@ -146,6 +147,17 @@ namespace c3::nu {
     return ret;
   }
 
+  /// As xml_encode, but building the output in mr
+  ///
+  /// XXX: escaped text is still built in short-lived std::strings first
+  inline std::pmr::string xml_encode(const markup_struct& ms, std::pmr::memory_resource* mr) {
+    std::pmr::string ret{mr};
+
+    detail::xml_encode_impl(ms, ret);
+
+    return ret;
+  }
+
   inline std::string xml_encode(std::string_view value) {
     return xml_string_escape(value);
   }
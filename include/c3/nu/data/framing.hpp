@@ -0,0 +1,159 @@
+#pragma once
+
+#include "c3/nu/data.hpp"
+#include "c3/nu/data/checksum.hpp"
+#include "c3/nu/data/collections/mixed.hpp"
+
+// Frames guard a serialised payload against truncation and corruption, and are laid out as:
+//
+//   length   the payload length, as a big-endian frame_size_type
+//   payload  the serialised value
+//   crc      the CRC32C of the length and payload, as a big-endian uint32_t
+//
+// The checksum is taken as the payload is written, so framing does not need a second pass over it.
+
+namespace c3::nu {
+  using frame_size_type = uint32_t;
+
+  /// The bytes a frame adds around its payload
+  constexpr size_t frame_overhead = sizeof(frame_size_type) + sizeof(uint32_t);
+
+  /// Passes everything through to another sink, keeping a running CRC32C of it
+  ///
+  /// XXX: claimed bytes are only checksummed on the next call to the sink (or to crc()), so they must be
+  /// filled in before then. This is what every sink already requires, as claimed spans may move.
+  template<typename Sink>
+  class checksum_sink {
+  private:
+    Sink& _inner;
+    data_ref _pending;
+    uint32_t _crc;
+
+  private:
+    inline void _fold_pending() {
+      _crc = crc32c(_pending, _crc);
+      _pending = {};
+    }
+
+  public:
+    inline size_t size() const { return _inner.size(); }
+
+    inline void reserve(size_t n) {
+      // Reserving may move what was claimed
+      _fold_pending();
+      _inner.reserve(n);
+    }
+
+    inline data_ref claim(size_t n) {
+      _fold_pending();
+      return _pending = _inner.claim(n);
+    }
+
+    inline void append(data_const_ref b) {
+      _fold_pending();
+      _crc = crc32c(b, _crc);
+      _inner.append(b);
+    }
+    inline void append_borrowed(data_const_ref b) {
+      _fold_pending();
+      _crc = crc32c(b, _crc);
+      _inner.append_borrowed(b);
+    }
+
+    /// The CRC32C of everything written through this sink so far
+    inline uint32_t crc() {
+      _fold_pending();
+      return _crc;
+    }
+
+  public:
+    /// Passing a previous crc() continues that checksum
+    inline checksum_sink(Sink& inner, uint32_t crc = 0) : _inner{inner}, _crc{crc} {}
+  };
+
+  /// Writes a frame of payload_len bytes, which write(sink) must fill exactly
+  template<typename Sink, typename F>
+  inline void frame_into(Sink& s, size_t payload_len, F&& write) {
+    if (!integer_can_hold<frame_size_type>(payload_len))
+      throw serialisation_failure("Payload too large for a frame");
+    s.reserve(payload_len + frame_overhead);
+
+    checksum_sink<Sink> cs{s};
+    serialise_static(static_cast<frame_size_type>(payload_len), cs.claim(sizeof(frame_size_type)));
+
+    auto start = s.size();
+    write(cs);
+    if (s.size() - start != payload_len)
+      throw serialisation_failure("Frame payload disagreed with its length");
+
+    // Claiming may move the payload's last claimed bytes, so they must be checksummed first
+    auto crc = cs.crc();
+    serialise_static(crc, s.claim(sizeof(uint32_t)));
+  }
+
+  template<typename T, typename Sink>
+  inline void serialise_framed_into(const T& t, Sink& s) {
+    if constexpr (knows_serialised_size_v<T>)
+      frame_into(s, serialised_size_of(t), [&](auto& cs) { serialise_into(t, cs); });
+    else {
+      // Sizing t would serialise it, so only do that once
+      auto buf = serialise(t);
+      frame_into(s, buf.size(), [&](auto& cs) { cs.append(buf); });
+    }
+  }
+
+  template<typename T>
+  inline data serialise_framed(const T& t) {
+    data ret;
+    data_sink sink{ret};
+    serialise_framed_into(t, sink);
+    return ret;
+  }
+
+  template<typename SizeType = hybrid_collection, typename Sink, typename... Ts>
+  inline void squash_framed_into(Sink& s, const Ts&... ts) {
+    if constexpr ((knows_serialised_size_v<Ts> && ...))
+      frame_into(s, squashed_size<SizeType>(ts...), [&](auto& cs) { squash_into<SizeType>(cs, ts...); });
+    else {
+      data buf;
+      data_sink buf_sink{buf};
+      squash_into<SizeType>(buf_sink, ts...);
+      frame_into(s, buf.size(), [&](auto& cs) { cs.append(buf); });
+    }
+  }
+
+  /// As squash, but framed
+  template<typename SizeType = hybrid_collection, typename... Ts>
+  inline data squash_framed(const Ts&... ts) {
+    data ret;
+    data_sink sink{ret};
+    squash_framed_into<SizeType>(sink, ts...);
+    return ret;
+  }
+
+  /// Checks the frame at the front of b, advances b past it, and returns its payload
+  inline data_const_ref read_frame(data_const_ref& b) {
+    if (static_cast<size_t>(b.size()) < frame_overhead)
+      throw serialisation_failure("Truncated frame");
+
+    auto len = static_cast<size_t>(deserialise<frame_size_type>(b.subspan(0, sizeof(frame_size_type))));
+    if (len > static_cast<size_t>(b.size()) - frame_overhead)
+      throw serialisation_failure("Truncated frame");
+
+    auto covered = b.subspan(0, sizeof(frame_size_type) + len);
+    auto crc = deserialise<uint32_t>(b.subspan(covered.size(), sizeof(uint32_t)));
+    if (crc32c(covered) != crc)
+      throw serialisation_failure("Frame checksum mismatch");
+
+    b = b.subspan(covered.size() + sizeof(uint32_t));
+    return covered.subspan(sizeof(frame_size_type));
+  }
+
+  /// The payload of b, which must be exactly one frame
+  inline data_const_ref unframe(data_const_ref b) {
+    auto ret = read_frame(b);
+    if (b.size() != 0)
+      throw serialisation_failure("Spare bytes after frame");
+    return ret;
+  }
+}
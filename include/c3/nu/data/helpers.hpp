@@ -4,6 +4,7 @@
 // #pragma once
 
 #include <type_traits>
+#include <tuple>
 
 #define C3_NU_DEFER_SERIALISATION_TYPE(TYPE, BASE_TYPE) \
   template<typename TemplateTypeArg69> \
@@ -16,6 +17,17 @@
   } \
   c3::nu::data _serialise() const override { \
     return c3::nu::serialise(static_cast<const BASE_TYPE&>(*this)); \
+  } \
+  template<typename TemplateTypeArg69, typename TemplateSinkArg69> \
+  friend void c3::nu::serialise_into(const TemplateTypeArg69&, TemplateSinkArg69&); \
+  template<typename TemplateSinkArg69> \
+  void _serialise_into(TemplateSinkArg69& s) const { \
+    c3::nu::serialise_into(static_cast<const BASE_TYPE&>(*this), s); \
+  } \
+  template<typename TemplateTypeArg69> \
+  friend constexpr size_t c3::nu::serialised_size_of(const TemplateTypeArg69&); \
+  size_t _serialised_size_of() const { \
+    return c3::nu::serialised_size_of(static_cast<const BASE_TYPE&>(*this)); \
   }
 
 #define C3_NU_DEFER_STATIC_SERIALISATION_TYPE(TYPE, BASE_TYPE) \
@@ -46,6 +58,17 @@
   } \
   c3::nu::data _serialise() const override { \
     return c3::nu::serialise(static_cast<const decltype(BASE_VAR)&>(BASE_VAR)); \
+  } \
+  template<typename TemplateTypeArg69, typename TemplateSinkArg69> \
+  friend void c3::nu::serialise_into(const TemplateTypeArg69&, TemplateSinkArg69&); \
+  template<typename TemplateSinkArg69> \
+  void _serialise_into(TemplateSinkArg69& s) const { \
+    c3::nu::serialise_into(static_cast<const decltype(BASE_VAR)&>(BASE_VAR), s); \
+  } \
+  template<typename TemplateTypeArg69> \
+  friend constexpr size_t c3::nu::serialised_size_of(const TemplateTypeArg69&); \
+  size_t _serialised_size_of() const { \
+    return c3::nu::serialised_size_of(static_cast<const decltype(BASE_VAR)&>(BASE_VAR)); \
   }
 
 #define C3_NU_DEFER_STATIC_SERIALISATION_VAR(TYPE, BASE_VAR) \
@@ -84,6 +107,98 @@
   static constexpr size_t _serialised_size = SERIALISED_SIZE; \
   static TYPE _deserialise(c3::nu::data_const_ref DATA_VAR_NAME)
 
+// The CRTP variants below do the same as the ones above, but for crtp_serialisable and
+// crtp_static_serialisable, which call into the type directly instead of through overrides
+
+#define C3_NU_CRTP_FRIENDS_INTERNAL(TYPE) \
+  friend c3::nu::crtp_serialisable<TYPE>; \
+  template<typename TemplateTypeArg69> \
+  friend c3::nu::data c3::nu::serialise(const TemplateTypeArg69&); \
+  template<typename TemplateTypeArg69> \
+  friend TemplateTypeArg69 c3::nu::deserialise(c3::nu::data_const_ref); \
+  template<typename TemplateTypeArg69, typename TemplateSinkArg69> \
+  friend void c3::nu::serialise_into(const TemplateTypeArg69&, TemplateSinkArg69&); \
+  template<typename TemplateTypeArg69> \
+  friend constexpr size_t c3::nu::serialised_size_of(const TemplateTypeArg69&); \
+  template<typename TemplateTypeArg69> \
+  friend constexpr size_t c3::nu::serialised_size(); \
+  template<typename TemplateTypeArg69> \
+  friend void c3::nu::serialise_static(const TemplateTypeArg69&, c3::nu::data_ref d);
+
+#define C3_NU_DEFER_CRTP_SERIALISATION_TYPE(TYPE, BASE_TYPE) \
+  C3_NU_CRTP_FRIENDS_INTERNAL(TYPE) \
+  private: \
+  static TYPE _deserialise(c3::nu::data_const_ref b) { \
+    return static_cast<TYPE>(c3::nu::deserialise<BASE_TYPE>(b)); \
+  } \
+  c3::nu::data _serialise() const { \
+    return c3::nu::serialise(static_cast<const BASE_TYPE&>(*this)); \
+  } \
+  template<typename TemplateSinkArg69> \
+  void _serialise_into(TemplateSinkArg69& s) const { \
+    c3::nu::serialise_into(static_cast<const BASE_TYPE&>(*this), s); \
+  } \
+  size_t _serialised_size_of() const { \
+    return c3::nu::serialised_size_of(static_cast<const BASE_TYPE&>(*this)); \
+  }
+
+#define C3_NU_DEFER_CRTP_SERIALISATION_VAR(TYPE, BASE_VAR) \
+  C3_NU_CRTP_FRIENDS_INTERNAL(TYPE) \
+  private: \
+  static TYPE _deserialise(c3::nu::data_const_ref b) { \
+    return static_cast<TYPE>(c3::nu::deserialise<decltype(BASE_VAR)>(b)); \
+  } \
+  c3::nu::data _serialise() const { \
+    return c3::nu::serialise(static_cast<const decltype(BASE_VAR)&>(BASE_VAR)); \
+  } \
+  template<typename TemplateSinkArg69> \
+  void _serialise_into(TemplateSinkArg69& s) const { \
+    c3::nu::serialise_into(static_cast<const decltype(BASE_VAR)&>(BASE_VAR), s); \
+  } \
+  size_t _serialised_size_of() const { \
+    return c3::nu::serialised_size_of(static_cast<const decltype(BASE_VAR)&>(BASE_VAR)); \
+  }
+
+#define C3_NU_DEFER_CRTP_STATIC_SERIALISATION_TYPE(TYPE, BASE_TYPE) \
+  C3_NU_CRTP_FRIENDS_INTERNAL(TYPE) \
+  private: \
+  static constexpr size_t _serialised_size = c3::nu::serialised_size<BASE_TYPE>(); \
+  static TYPE _deserialise(c3::nu::data_const_ref b) { \
+    return static_cast<TYPE>(c3::nu::deserialise<BASE_TYPE>(b)); \
+  } \
+  void _serialise_static(c3::nu::data_ref b) const { \
+    c3::nu::serialise_static(static_cast<const BASE_TYPE&>(*this), b); \
+  }
+
+#define C3_NU_DEFER_CRTP_STATIC_SERIALISATION_VAR(TYPE, BASE_VAR) \
+  C3_NU_CRTP_FRIENDS_INTERNAL(TYPE) \
+  private: \
+  static constexpr size_t _serialised_size = c3::nu::serialised_size<decltype(BASE_VAR)>(); \
+  static TYPE _deserialise(c3::nu::data_const_ref b) { \
+    return static_cast<TYPE>(c3::nu::deserialise<decltype(BASE_VAR)>(b)); \
+  } \
+  void _serialise_static(c3::nu::data_ref b) const { \
+    c3::nu::serialise_static(static_cast<const decltype(BASE_VAR)&>(BASE_VAR), b); \
+  }
+
+#define C3_NU_DEFINE_CRTP_DESERIALISE(TYPE, DATA_VAR_NAME) \
+  C3_NU_CRTP_FRIENDS_INTERNAL(TYPE) \
+  private: \
+  static TYPE _deserialise(c3::nu::data_const_ref DATA_VAR_NAME)
+
+#define C3_NU_DEFINE_CRTP_STATIC_DESERIALISE(TYPE, SERIALISED_SIZE, DATA_VAR_NAME) \
+  C3_NU_CRTP_FRIENDS_INTERNAL(TYPE) \
+  private: \
+  static constexpr size_t _serialised_size = SERIALISED_SIZE; \
+  static TYPE _deserialise(c3::nu::data_const_ref DATA_VAR_NAME)
+
+/// Lists the fields of a plain struct, which is then statically serialised as those fields in order
+#define C3_NU_FIELDS(...) \
+  friend struct c3::nu::field_access; \
+  private: \
+  auto _fields() { return std::tie(__VA_ARGS__); } \
+  auto _fields() const { return std::tie(__VA_ARGS__); }
+
 #define C3_NU_SERIALISED_SIZE(TYPE, VALUE) \
   template<> \
   constexpr size_t c3::nu::serialised_size<TYPE>() { return VALUE; }
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "c3/nu/data.hpp"
+#include "c3/nu/data/checksum.hpp"
+#include "c3/nu/data/collections/sequence.hpp"
+#include "c3/nu/data/collections/static.hpp"
+
+// A sealed, append-only segment of records, laid out as:
+//
+//   header   "C3NUREC1"
+//   records  squash_seq<record_size_type> of every record, so that the area is itself a valid sequence
+//   index    the offset of every record from the start of the file, as uint64_ts
+//   crcs     the CRC32C of each block of records_per_block records, as uint32_ts
+//   trailer  record count (uint64_t), index offset (uint64_t), records per block (uint32_t),
+//            CRC32C of the index and crcs (uint32_t), CRC32C of the trailer so far (uint32_t), "C3NUEND1"
+//
+// All integers are big-endian. The trailer has a fixed size, so a reader can find everything from the end
+// of the file without touching the records.
+
+namespace c3::nu {
+  using record_size_type = uint32_t;
+
+  namespace _record_file {
+    constexpr static_data<8> header_magic = { 'C', '3', 'N', 'U', 'R', 'E', 'C', '1' };
+    constexpr static_data<8> trailer_magic = { 'C', '3', 'N', 'U', 'E', 'N', 'D', '1' };
+
+    constexpr size_t header_len = header_magic.size();
+    constexpr size_t trailer_len = 8 + 8 + 4 + 4 + 4 + trailer_magic.size();
+  }
+
+  /// Writes a record file, sealing it with the footer on finish()
+  class record_file_writer {
+  public:
+    static constexpr uint32_t default_records_per_block = 1024;
+
+  private:
+    std::ofstream _out;
+    uint64_t _offset = 0;
+    uint32_t _records_per_block;
+    std::vector<uint64_t> _offsets;
+    std::vector<uint32_t> _crcs;
+    uint32_t _block_crc = 0;
+    data _buf;
+    bool _finished = false;
+
+  private:
+    inline void _write(data_const_ref b) {
+      _out.write(reinterpret_cast<const char*>(b.data()), static_cast<std::streamsize>(b.size()));
+      if (!_out)
+        throw std::system_error(errno, std::generic_category(), "Could not write record file");
+      _offset += static_cast<uint64_t>(b.size());
+    }
+
+  public:
+    /// Serialises t as the next record
+    template<typename T>
+    inline void append(const T& t) {
+      if (_finished)
+        throw std::logic_error("Record file already finished");
+
+      if (!_offsets.empty() && _offsets.size() % _records_per_block == 0) {
+        _crcs.push_back(_block_crc);
+        _block_crc = 0;
+      }
+
+      _buf.clear();
+      data_sink sink{_buf};
+      serialise_into_prefixed<record_size_type>(t, sink);
+
+      _block_crc = crc32c(_buf, _block_crc);
+      _offsets.push_back(_offset);
+      _write(_buf);
+    }
+
+    inline size_t size() const { return _offsets.size(); }
+
+    /// Writes the footer and closes the file
+    inline void finish() {
+      if (_finished)
+        return;
+      _finished = true;
+
+      if (!_offsets.empty())
+        _crcs.push_back(_block_crc);
+
+      uint64_t index_offset = _offset;
+      data footer = squash_seq(_offsets.begin(), _offsets.end());
+      data crcs = squash_seq(_crcs.begin(), _crcs.end());
+      footer.insert(footer.end(), crcs.begin(), crcs.end());
+
+      data trailer = squash_static(static_cast<uint64_t>(_offsets.size()), index_offset,
+                                   _records_per_block, crc32c(footer));
+      data trailer_crc = serialise(crc32c(trailer));
+      trailer.insert(trailer.end(), trailer_crc.begin(), trailer_crc.end());
+      trailer.insert(trailer.end(), _record_file::trailer_magic.begin(), _record_file::trailer_magic.end());
+
+      _write(footer);
+      _write(trailer);
+      _out.close();
+      if (!_out)
+        throw std::system_error(errno, std::generic_category(), "Could not close record file");
+    }
+
+  public:
+    inline record_file_writer(const std::string& path, uint32_t records_per_block = default_records_per_block) :
+        _records_per_block{records_per_block} {
+      // Checked before opening, which truncates whatever is already there
+      if (records_per_block == 0)
+        throw std::invalid_argument("records_per_block must be positive");
+      _out.open(path, std::ios::binary | std::ios::trunc);
+      if (!_out)
+        throw std::system_error(errno, std::generic_category(), "Could not open record file");
+      _write(_record_file::header_magic);
+    }
+
+    record_file_writer(const record_file_writer&) = delete;
+    record_file_writer& operator=(const record_file_writer&) = delete;
+
+    /// XXX: errors here are swallowed, so call finish() to see them
+    inline ~record_file_writer() {
+      try { finish(); }
+      catch (...) {}
+    }
+  };
+
+  /// A memory-mapped, read-only record file
+  ///
+  /// Opening only reads the trailer, and a lookup only touches its index entry and the record itself,
+  /// so the records returned borrow from the mapping and must not outlive this
+  class record_file {
+  private:
+    const uint8_t* _map = nullptr;
+    size_t _map_len = 0;
+
+    data_const_ref _file;
+    data_const_ref _index;
+    data_const_ref _crcs;
+    size_t _size = 0;
+    uint64_t _index_offset = 0;
+    uint32_t _records_per_block = 0;
+    uint32_t _footer_crc = 0;
+
+  private:
+    inline uint64_t _offset_of(size_t i) const {
+      return deserialise<uint64_t>(_index.subspan(i * sizeof(uint64_t), sizeof(uint64_t)));
+    }
+
+    inline void _check_block(size_t block) const {
+      auto first = block * _records_per_block;
+      auto start = _offset_of(first);
+      auto end = first + _records_per_block < _size ? _offset_of(first + _records_per_block) : _index_offset;
+      if (start < _record_file::header_len || end < start || end > _index_offset)
+        throw serialisation_failure("Corrupt record index");
+
+      auto expected = deserialise<uint32_t>(_crcs.subspan(block * sizeof(uint32_t), sizeof(uint32_t)));
+      if (crc32c(_file.subspan(start, end - start)) != expected)
+        throw serialisation_failure("Record block checksum mismatch");
+    }
+
+    inline void _unmap() {
+      if (_map)
+        ::munmap(const_cast<uint8_t*>(_map), _map_len);
+      _map = nullptr;
+    }
+
+  public:
+    inline size_t size() const { return _size; }
+    inline bool empty() const { return _size == 0; }
+
+    /// The serialised form of record i, borrowed from the mapping
+    inline data_const_ref record(size_t i) const {
+      if (i >= _size)
+        throw std::out_of_range("Record index out of range");
+
+      auto offset = _offset_of(i);
+      if (offset < _record_file::header_len || offset > _index_offset)
+        throw serialisation_failure("Corrupt record index");
+
+      auto rest = _file.subspan(offset, _index_offset - offset);
+      auto len = size_prefix<record_size_type>::try_read(rest);
+      if (!len || *len > static_cast<size_t>(rest.size()))
+        throw serialisation_failure("Record overruns the record area");
+      return rest.subspan(0, *len);
+    }
+
+    /// As record, but first checks the checksum of the block holding it
+    inline data_const_ref record_checked(size_t i) const {
+      if (i >= _size)
+        throw std::out_of_range("Record index out of range");
+      _check_block(i / _records_per_block);
+      return record(i);
+    }
+
+    template<typename T>
+    inline T get(size_t i) const { return deserialise<T>(record(i)); }
+
+    /// Every record in order, through the sequence they are stored as
+    ///
+    /// XXX: seq_view checks the framing of every record up front, so this reads the whole record area
+    inline seq_view<data_const_ref, record_size_type> records() const {
+      return { _file.subspan(_record_file::header_len, _index_offset - _record_file::header_len) };
+    }
+
+    /// Checks every checksum in the file, which reads all of it
+    inline void verify() const {
+      if (crc32c(_file.subspan(_index_offset, _index.size() + _crcs.size())) != _footer_crc)
+        throw serialisation_failure("Record index checksum mismatch");
+      for (size_t i = 0; i < static_cast<size_t>(_crcs.size()) / sizeof(uint32_t); ++i)
+        _check_block(i);
+    }
+
+  public:
+    inline record_file(const std::string& path) {
+      int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "Could not open record file");
+
+      struct stat st;
+      if (::fstat(fd, &st) != 0) {
+        auto err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "Could not stat record file");
+      }
+      _map_len = static_cast<size_t>(st.st_size);
+
+      if (_map_len < _record_file::header_len + _record_file::trailer_len) {
+        ::close(fd);
+        throw serialisation_failure("Record file too small");
+      }
+
+      void* map = ::mmap(nullptr, _map_len, PROT_READ, MAP_SHARED, fd, 0);
+      auto err = errno;
+      ::close(fd);
+      if (map == MAP_FAILED)
+        throw std::system_error(err, std::generic_category(), "Could not map record file");
+      _map = static_cast<const uint8_t*>(map);
+
+      try {
+        _file = { _map, static_cast<data_const_ref::index_type>(_map_len) };
+
+        auto header = _file.subspan(0, _record_file::header_len);
+        auto trailer = _file.subspan(_map_len - _record_file::trailer_len);
+        auto magic = trailer.subspan(_record_file::trailer_len - _record_file::trailer_magic.size());
+        if (!std::equal(header.begin(), header.end(), _record_file::header_magic.begin()) ||
+            !std::equal(magic.begin(), magic.end(), _record_file::trailer_magic.begin()))
+          throw serialisation_failure("Not a record file");
+
+        uint64_t size;
+        uint32_t trailer_crc;
+        expand_static(trailer.subspan(0, 28), size, _index_offset, _records_per_block, _footer_crc, trailer_crc);
+        if (crc32c(trailer.subspan(0, 24)) != trailer_crc)
+          throw serialisation_failure("Record file trailer checksum mismatch");
+
+        if (_records_per_block == 0 || !integer_can_hold<size_t>(size))
+          throw serialisation_failure("Corrupt record file trailer");
+        _size = static_cast<size_t>(size);
+
+        // Everything between the index and the trailer must be exactly the index and the crcs
+        auto n_blocks = divide_ceil<size_t>(_size, _records_per_block);
+        auto footer_len = _map_len - _record_file::trailer_len;
+        if (_index_offset < _record_file::header_len || _index_offset > footer_len ||
+            _size > (footer_len - _index_offset) / sizeof(uint64_t) ||
+            footer_len - _index_offset != _size * sizeof(uint64_t) + n_blocks * sizeof(uint32_t))
+          throw serialisation_failure("Corrupt record file trailer");
+
+        _index = _file.subspan(_index_offset, _size * sizeof(uint64_t));
+        _crcs = _file.subspan(_index_offset + _index.size(), n_blocks * sizeof(uint32_t));
+      }
+      catch (...) {
+        _unmap();
+        throw;
+      }
+    }
+
+    record_file(const record_file&) = delete;
+    record_file& operator=(const record_file&) = delete;
+
+    inline ~record_file() { _unmap(); }
+  };
+}
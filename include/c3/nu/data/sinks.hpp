@@ -0,0 +1,277 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#endif
+
+#include "c3/nu/data/size_prefix.hpp"
+#include "c3/nu/integer.hpp"
+
+//! Sinks are the targets of serialise_into
+//!
+//! A sink must provide:
+//! * size(): the number of bytes written so far
+//! * reserve(n): a hint that n more bytes are about to be written
+//! * claim(n): extends the output by n bytes, and returns them to be filled in.
+//!   The returned span is only valid until the next call on the sink
+//! * append(b): copies b onto the end of the output
+//! * append_borrowed(b): as append, but the caller guarantees b outlives the output,
+//!   so the sink is free to reference it rather than copy it
+//!
+//! Sinks that write to contiguous memory also provide written(), a mutable view of
+//! everything written so far
+
+namespace c3::nu {
+  /// Appends to a caller-owned buffer, growing it as needed
+  ///
+  /// The buffer may use any allocator, so output can go straight into an arena through pmr::data_sink
+  template<typename Data>
+  class basic_data_sink {
+  private:
+    Data& _buf;
+
+  public:
+    inline size_t size() const { return _buf.size(); }
+
+    inline void reserve(size_t n) {
+      auto required = _buf.size() + n;
+      // Keep the geometric growth of the vector, otherwise repeated reserves become quadratic
+      if (required > _buf.capacity())
+        _buf.reserve(std::max(required, _buf.capacity() * 2));
+    }
+
+    inline data_ref claim(size_t n) {
+      auto pos = _buf.size();
+      reserve(n);
+      _buf.resize(pos + n);
+      return { _buf.data() + pos, static_cast<data_ref::size_type>(n) };
+    }
+
+    inline void append(data_const_ref b) {
+      _buf.insert(_buf.end(), b.begin(), b.end());
+    }
+    inline void append_borrowed(data_const_ref b) { append(b); }
+
+    inline data_ref written() { return _buf; }
+
+  public:
+    inline basic_data_sink(Data& buf) : _buf{buf} {}
+  };
+
+  using data_sink = basic_data_sink<data>;
+  namespace pmr {
+    using data_sink = basic_data_sink<pmr::data>;
+  }
+
+  /// Writes into a fixed, caller-owned span, throwing if it would overrun
+  class span_sink {
+  private:
+    data_ref _buf;
+    size_t _pos = 0;
+
+  private:
+    inline size_t remaining() const { return static_cast<size_t>(_buf.size()) - _pos; }
+
+  public:
+    inline size_t size() const { return _pos; }
+
+    inline void reserve(size_t n) {
+      if (n > remaining())
+        throw serialisation_failure("Sink is too small");
+    }
+
+    inline data_ref claim(size_t n) {
+      reserve(n);
+      data_ref ret{_buf.data() + _pos, static_cast<data_ref::size_type>(n)};
+      _pos += n;
+      return ret;
+    }
+
+    inline void append(data_const_ref b) {
+      auto to_fill = claim(static_cast<size_t>(b.size()));
+      std::copy(b.begin(), b.end(), to_fill.begin());
+    }
+    inline void append_borrowed(data_const_ref b) { append(b); }
+
+    inline data_ref written() { return { _buf.data(), static_cast<data_ref::size_type>(_pos) }; }
+
+  public:
+    inline span_sink(data_ref buf) : _buf{buf} {}
+  };
+
+  /// Collects output as a list of segments, so that it can be sent with a single gathering write
+  ///
+  /// Small writes (static fields, length prefixes, short strings) are copied into a scratch buffer,
+  /// whilst large borrowed buffers are referenced in place. The segments therefore borrow from the
+  /// values that were serialised, and must not outlive them.
+  class gather_sink {
+  public:
+    /// Borrowed buffers shorter than this are copied, as a tiny extra segment costs more than the copy
+    static constexpr size_t default_borrow_threshold = 256;
+
+  private:
+    struct segment {
+      /// nullptr means the segment lives in the scratch buffer, which may move as it grows
+      const uint8_t* ptr;
+      size_t offset;
+      size_t len;
+    };
+
+  private:
+    data _scratch;
+    std::vector<segment> _segments;
+    size_t _size = 0;
+    size_t _borrow_threshold;
+
+  public:
+    inline size_t size() const { return _size; }
+
+    /// We cannot know how much of the output will end up in scratch, so this is just a hint
+    inline void reserve(size_t) {}
+
+    inline data_ref claim(size_t n) {
+      auto pos = _scratch.size();
+      _scratch.resize(pos + n);
+      _size += n;
+
+      if (!_segments.empty() && _segments.back().ptr == nullptr)
+        // We are still contiguous with the last bit of scratch, so just extend it
+        _segments.back().len += n;
+      else
+        _segments.push_back({ nullptr, pos, n });
+
+      return { _scratch.data() + pos, static_cast<data_ref::size_type>(n) };
+    }
+
+    inline void append(data_const_ref b) {
+      auto to_fill = claim(static_cast<size_t>(b.size()));
+      std::copy(b.begin(), b.end(), to_fill.begin());
+    }
+
+    inline void append_borrowed(data_const_ref b) {
+      auto len = static_cast<size_t>(b.size());
+      if (len < _borrow_threshold)
+        return append(b);
+
+      _segments.push_back({ b.data(), 0, len });
+      _size += len;
+    }
+
+    /// The output, in order. Only valid until the sink is next written to
+    inline std::vector<data_const_ref> segments() const {
+      std::vector<data_const_ref> ret;
+      ret.reserve(_segments.size());
+      for (auto& i : _segments) {
+        auto* ptr = i.ptr ? i.ptr : _scratch.data() + i.offset;
+        ret.emplace_back(ptr, static_cast<data_const_ref::size_type>(i.len));
+      }
+      return ret;
+    }
+
+#if __has_include(<sys/uio.h>)
+    /// The output as an array that can be passed straight to writev or sendmsg.
+    /// Only valid until the sink is next written to
+    inline std::vector<::iovec> iovecs() const {
+      std::vector<::iovec> ret;
+      ret.reserve(_segments.size());
+      for (auto& i : _segments) {
+        auto* ptr = i.ptr ? i.ptr : _scratch.data() + i.offset;
+        ret.push_back({ const_cast<uint8_t*>(ptr), i.len });
+      }
+      return ret;
+    }
+#endif
+
+    /// Copies all the segments into one buffer
+    inline data flatten() const {
+      data ret;
+      ret.reserve(_size);
+      for (auto i : segments())
+        ret.insert(ret.end(), i.begin(), i.end());
+      return ret;
+    }
+
+    inline void clear() {
+      _scratch.clear();
+      _segments.clear();
+      _size = 0;
+    }
+
+  public:
+    inline gather_sink(size_t borrow_threshold = default_borrow_threshold) :
+      _borrow_threshold{borrow_threshold} {}
+  };
+
+  /// Serialises each argument onto the end of s, one after the other
+  ///
+  /// With a gather_sink this produces segments ready for writev, without copying large fields
+  template<typename Sink, typename Head, typename... Tail>
+  inline void serialise_all_into(Sink& s, const Head& head, const Tail&... tail) {
+    serialise_into(head, s);
+    if constexpr (sizeof...(Tail) > 0)
+      serialise_all_into(s, tail...);
+  }
+
+  /// Serialises t into s with its integers in the given byte order
+  template<byte_order Order, typename T, typename Sink>
+  inline void serialise_into(const T& t, Sink& s) {
+    if constexpr (Order != byte_order::big && is_static_serialisable_v<T>)
+      serialise_static<T, Order>(t, s.claim(serialised_size<T>()));
+    else
+      serialise_into(t, s);
+  }
+
+  /// The number of bytes serialise_into_prefixed would write
+  template<typename SizeType, typename T>
+  inline size_t serialised_size_prefixed(const T& t) {
+    auto len = serialised_size_of(t);
+    return size_prefix<SizeType>::len(len) + len;
+  }
+
+  namespace _prefixed {
+    template<typename Sink, typename = void>
+    struct has_written : std::false_type {};
+    template<typename Sink>
+    struct has_written<Sink, std::void_t<decltype(std::declval<Sink&>().written())>> : std::true_type {};
+  }
+
+  /// Serialises t into s, preceded by len, which must be its serialised length
+  template<typename SizeType, byte_order Order = byte_order::big, typename T, typename Sink>
+  inline void serialise_into_prefixed(const T& t, size_t len, Sink& s) {
+    size_prefix<SizeType>::template write<Order>(len, s);
+
+    auto start = s.size();
+    serialise_into<Order>(t, s);
+    if (s.size() - start != len)
+      throw serialisation_failure("serialised_size_of disagreed with the serialised length");
+  }
+
+  /// Serialises t into s, preceded by its length as a SizeType
+  ///
+  /// t is only ever serialised once. If it cannot be sized without serialising it, a fixed width prefix is
+  /// back-filled where the sink allows, and otherwise t is serialised to a buffer first.
+  template<typename SizeType, byte_order Order = byte_order::big, typename T, typename Sink>
+  inline void serialise_into_prefixed(const T& t, Sink& s) {
+    if constexpr (knows_serialised_size_v<T>)
+      serialise_into_prefixed<SizeType, Order>(t, serialised_size_of(t), s);
+    else if constexpr (!std::is_same_v<SizeType, varint> && _prefixed::has_written<Sink>::value) {
+      constexpr auto prefix_len = size_prefix<SizeType>::min_len;
+      auto prefix_pos = s.size();
+      s.claim(prefix_len);
+      serialise_into<Order>(t, s);
+
+      // The claim may have moved since, so look it up again
+      span_sink prefix{s.written().subspan(static_cast<data_ref::index_type>(prefix_pos), prefix_len)};
+      size_prefix<SizeType>::template write<Order>(s.size() - prefix_pos - prefix_len, prefix);
+    }
+    else {
+      // Copied rather than borrowed, as the buffer will not outlive the sink's output
+      auto buf = serialise(t);
+      size_prefix<SizeType>::template write<Order>(buf.size(), s);
+      s.append(buf);
+    }
+  }
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "c3/nu/data/byte_order.hpp"
+#include "c3/nu/integer.hpp"
+
+namespace c3::nu {
+  /// Used as a SizeType to prefix elements with an LEB128 varint rather than a fixed width integer
+  ///
+  /// Lengths under 128 take a single byte, and under 16384 take two
+  struct varint {};
+
+  /// The longest LEB128 encoding of a 64 bit integer
+  constexpr size_t varint_max_len = 10;
+
+  /// The number of bytes needed to encode i as a varint
+  constexpr size_t varint_len(uint64_t i) {
+    size_t ret = 1;
+    for (; i >= 0x80; i >>= 7, ++ret);
+    return ret;
+  }
+
+  /// Encodes i into the varint_len(i) bytes at d
+  inline void encode_varint(uint64_t i, uint8_t* d) {
+    for (; i >= 0x80; i >>= 7)
+      *d++ = static_cast<uint8_t>(i | 0x80);
+    *d = static_cast<uint8_t>(i);
+  }
+
+  namespace _varint {
+    /// Decodes one byte at a time, for the rare long values and the end of the buffer
+    inline uint64_t decode_slow(data_const_ref& b) {
+      uint64_t ret = 0;
+      auto n_bytes = std::min<size_t>(static_cast<size_t>(b.size()), varint_max_len);
+
+      for (size_t i = 0; i < n_bytes; ++i) {
+        uint64_t byte = b[i];
+        // The 10th byte only has room for the top bit
+        if (i == varint_max_len - 1 && byte > 1)
+          throw serialisation_failure("Varint overflows 64 bits");
+
+        ret |= (byte & 0x7f) << (7 * i);
+        if (!(byte & 0x80)) {
+          b = b.subspan(i + 1);
+          return ret;
+        }
+      }
+
+      if (n_bytes == varint_max_len)
+        throw serialisation_failure("Varint overflows 64 bits");
+      throw serialisation_failure("Truncated varint");
+    }
+  }
+
+  /// Decodes a varint from the front of b, and advances b past it
+  ///
+  /// Where 8 bytes are available, this finds the terminator and gathers the 7 bit groups of up to 56 bits
+  /// a word at a time, rather than branching on every byte
+  inline uint64_t decode_varint(data_const_ref& b) {
+    if (b.size() >= 8) {
+      uint64_t word;
+      std::memcpy(&word, b.data(), sizeof(word));
+      word = le64toh(word);
+
+      uint64_t terminators = ~word & 0x8080808080808080;
+      if (terminators != 0) {
+        auto len = static_cast<size_t>(__builtin_ctzll(terminators)) / 8 + 1;
+        // Only keep the bytes that belong to this varint
+        uint64_t x = len == 8 ? word : word & ((uint64_t{1} << (len * 8)) - 1);
+
+#if defined(__BMI2__)
+        x = _pext_u64(x, 0x7f7f7f7f7f7f7f7f);
+#else
+        x &= 0x7f7f7f7f7f7f7f7f;
+        x = ((x & 0x7f007f007f007f00) >> 1) | (x & 0x007f007f007f007f);
+        x = ((x & 0x3fff00003fff0000) >> 2) | (x & 0x00003fff00003fff);
+        x = ((x & 0x0fffffff00000000) >> 4) | (x & 0x000000000fffffff);
+#endif
+
+        b = b.subspan(len);
+        return x;
+      }
+    }
+
+    return _varint::decode_slow(b);
+  }
+
+  /// How elements are prefixed with their length, for a given SizeType
+  ///
+  /// XXX: the length of the prefix can depend on the value it holds, so is not always static
+  template<typename SizeType>
+  struct size_prefix {
+    static_assert(is_static_serialisable_v<SizeType>, "SizeType must be statically serialisable");
+
+    static constexpr size_t len(size_t) { return serialised_size<SizeType>(); }
+    /// The fewest bytes any prefix can take
+    static constexpr size_t min_len = serialised_size<SizeType>();
+
+    template<byte_order Order = byte_order::big, typename Sink>
+    static inline void write(size_t n, Sink& s) {
+      if (!integer_can_hold<SizeType>(n))
+        throw serialisation_failure("SizeType was too small to hold a value");
+      serialise_static<SizeType, Order>(static_cast<SizeType>(n), s.claim(serialised_size<SizeType>()));
+    }
+
+    /// Reads a length from the front of b, and advances b past it
+    template<byte_order Order = byte_order::big>
+    static inline size_t read(data_const_ref& b) {
+      SizeType len_s = deserialise<SizeType, Order>(b.subspan(0, serialised_size<SizeType>()));
+      if (!integer_can_hold<size_t>(len_s))
+        throw serialisation_failure("Element size overflows size_t");
+      b = b.subspan(serialised_size<SizeType>());
+      return static_cast<size_t>(len_s);
+    }
+
+    /// As read, but returns nothing (leaving b alone) if b ends part way through the prefix
+    template<byte_order Order = byte_order::big>
+    static inline std::optional<size_t> try_read(data_const_ref& b) {
+      if (static_cast<size_t>(b.size()) < serialised_size<SizeType>())
+        return std::nullopt;
+      return read<Order>(b);
+    }
+
+    /// Reads a length from p, which must already have been checked with read, and advances p past it
+    template<byte_order Order = byte_order::big>
+    static inline size_t read_unchecked(const uint8_t*& p) {
+      auto ret = static_cast<size_t>(deserialise_unchecked<SizeType, Order>(p));
+      p += serialised_size<SizeType>();
+      return ret;
+    }
+  };
+
+  /// Varints are byte order independent, so Order is ignored
+  template<>
+  struct size_prefix<varint> {
+    static constexpr size_t len(size_t n) { return varint_len(n); }
+    static constexpr size_t min_len = 1;
+
+    template<byte_order Order = byte_order::big, typename Sink>
+    static inline void write(size_t n, Sink& s) {
+      encode_varint(n, s.claim(varint_len(n)).data());
+    }
+
+    template<byte_order Order = byte_order::big>
+    static inline size_t read(data_const_ref& b) {
+      auto len = decode_varint(b);
+      if (!integer_can_hold<size_t>(len))
+        throw serialisation_failure("Element size overflows size_t");
+      return static_cast<size_t>(len);
+    }
+
+    template<byte_order Order = byte_order::big>
+    static inline std::optional<size_t> try_read(data_const_ref& b) {
+      // Anything this long is either complete or malformed, and read will say which
+      if (static_cast<size_t>(b.size()) < varint_max_len &&
+          std::all_of(b.begin(), b.end(), [](uint8_t i) { return i & 0x80; }))
+        return std::nullopt;
+      return read<Order>(b);
+    }
+
+    template<byte_order Order = byte_order::big>
+    static inline size_t read_unchecked(const uint8_t*& p) {
+      uint64_t ret = 0;
+      for (unsigned shift = 0;; shift += 7) {
+        uint64_t byte = *p++;
+        ret |= (byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+          return static_cast<size_t>(ret);
+      }
+    }
+  };
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <type_traits>
+#include <iterator>
+#include <string>
+#include <vector>
 
 #include "c3/nu/data/span_deps.hpp"
 
@@ -24,14 +27,15 @@ namespace c3::nu {
   template<typename Test>
   struct is_fixed_span : std::false_type {};
 
+  // Dynamic extent spans are spans too, but they are certainly not fixed
   template<typename T, std::ptrdiff_t Len>
-  struct is_fixed_span<gsl::span<T, Len>> : std::true_type {};
+  struct is_fixed_span<gsl::span<T, Len>> : std::bool_constant<Len != gsl::dynamic_extent> {};
   template<typename T, std::ptrdiff_t Len>
-  struct is_fixed_span<gsl::span<const T, Len>> : std::true_type {};
+  struct is_fixed_span<gsl::span<const T, Len>> : std::bool_constant<Len != gsl::dynamic_extent> {};
   template<typename T, std::ptrdiff_t Len>
-  struct is_fixed_span<gsl::span<volatile T, Len>> : std::true_type {};
+  struct is_fixed_span<gsl::span<volatile T, Len>> : std::bool_constant<Len != gsl::dynamic_extent> {};
   template<typename T, std::ptrdiff_t Len>
-  struct is_fixed_span<gsl::span<const volatile T, Len>> : std::true_type {};
+  struct is_fixed_span<gsl::span<const volatile T, Len>> : std::bool_constant<Len != gsl::dynamic_extent> {};
 
   template<typename T>
   constexpr bool is_fixed_span_v = is_fixed_span<T>::value;
@@ -51,6 +55,41 @@ namespace c3::nu {
   template<typename T>
   constexpr bool is_array_v = is_array<T>::value;
 
+  template<typename T>
+  constexpr bool is_char_v =
+    std::is_same_v<T, char> || std::is_same_v<T, wchar_t> ||
+    std::is_same_v<T, char16_t> || std::is_same_v<T, char32_t>;
+
+  /// Whether Iter is known to walk contiguous memory
+  ///
+  /// XXX: C++17 has no way to ask, so this only recognises pointers and the iterators of vector and string
+  template<typename Iter, typename = void>
+  struct is_contiguous_iter : std::is_pointer<Iter> {};
+
+  template<typename Iter>
+  struct is_contiguous_iter<Iter, typename std::enable_if<!std::is_pointer_v<Iter>>::type> {
+  private:
+    using value_t = typename std::iterator_traits<Iter>::value_type;
+
+    static constexpr bool is_string_iter() {
+      if constexpr (is_char_v<value_t>)
+        return std::is_same_v<Iter, typename std::basic_string<value_t>::iterator> ||
+               std::is_same_v<Iter, typename std::basic_string<value_t>::const_iterator>;
+      else
+        return false;
+    }
+
+  public:
+    static constexpr bool value =
+      !std::is_same_v<value_t, bool> &&
+      (std::is_same_v<Iter, typename std::vector<value_t>::iterator> ||
+       std::is_same_v<Iter, typename std::vector<value_t>::const_iterator> ||
+       is_string_iter());
+  };
+
+  template<typename Iter>
+  constexpr bool is_contiguous_iter_v = is_contiguous_iter<Iter>::value;
+
   template<size_t arg, typename FirstType, typename... Types>
   struct nth_type : nth_type<arg - 1, Types...> {};
   template<typename FirstType, typename... Types>
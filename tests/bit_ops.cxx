@@ -0,0 +1,119 @@
+#include "c3/nu/bit_ops.hpp"
+
+#include <random>
+
+using namespace c3::nu;
+
+template<typename Op, typename Naive>
+void check_op(std::mt19937_64& rng, Op op, Naive naive) {
+  data src_buf(300), dst_buf(300);
+  for (auto& i : src_buf) i = static_cast<uint8_t>(rng());
+  for (auto& i : dst_buf) i = static_cast<uint8_t>(rng());
+  bits_const_ref src{src_buf};
+
+  // Every mix of alignments, with lengths either side of the vector and word sizes
+  for (size_t dst_pos : { 0, 1, 7, 8, 13 })
+    for (size_t src_pos : { 0, 3, 8, 16, 21 })
+      for (size_t n : { 0, 1, 7, 8, 63, 64, 65, 127, 128, 255, 256, 257, 1000, 2000 }) {
+        auto expected = dst_buf;
+        bits_ref e{expected};
+        for (size_t i = 0; i < n; ++i)
+          if (naive(e.get_bit(dst_pos + i), src.get_bit(src_pos + i)))
+            e.set_bit(dst_pos + i);
+          else
+            e.clear_bit(dst_pos + i);
+
+        auto actual = dst_buf;
+        op(bits_ref{actual}, dst_pos, src, src_pos, n);
+        if (actual != expected)
+          throw std::runtime_error("Wrong result");
+      }
+
+  // Ranges are checked against both lengths
+  bool threw = false;
+  try { op(bits_ref{dst_buf.data(), 100}, 0, bits_const_ref{src_buf.data(), 50}, 0, 60); }
+  catch (std::out_of_range&) { threw = true; }
+  if (!threw)
+    throw std::runtime_error("Overrun accepted");
+}
+
+int main() {
+  std::mt19937_64 rng{11};
+
+  check_op(rng, [](auto... args) { bits_and(args...); }, [](bool d, bool s) { return d && s; });
+  check_op(rng, [](auto... args) { bits_or(args...); }, [](bool d, bool s) { return d || s; });
+  check_op(rng, [](auto... args) { bits_xor(args...); }, [](bool d, bool s) { return d != s; });
+  check_op(rng, [](auto... args) { bits_andnot(args...); }, [](bool d, bool s) { return d && !s; });
+
+  {
+    data a{0xf0, 0x0f}, b{0xff, 0x00};
+    bits_xor(bits_ref{a}, bits_const_ref{b});
+    if (a != data{0x0f, 0x0f})
+      throw std::runtime_error("Whole range xor failed");
+  }
+
+  for (unsigned density : { 0, 1, 16, 128, 256 }) {
+    data buf(700);
+    for (auto& i : buf) {
+      i = 0;
+      for (size_t bit = 0; bit < CHAR_BIT; ++bit)
+        if (rng() % 256 < density)
+          i |= 1 << bit;
+    }
+
+    for (size_t len : { 0, 1, 9, 64, 100, 511, 4000, 8 * 700 }) {
+      bits_const_ref bits{buf.data(), len};
+
+      std::vector<size_t> set;
+      for (size_t i = 0; i < len; ++i)
+        if (bits.get_bit(i))
+          set.push_back(i);
+
+      if (count_set_bits(bits) != set.size())
+        throw std::runtime_error("Wrong count");
+      for (size_t pos : { 1, 5, 33 })
+        for (size_t n : { 0, 3, 70, 300, 3000 }) {
+          if (pos + n > len)
+            continue;
+          size_t expected = 0;
+          for (size_t i = pos; i < pos + n; ++i)
+            expected += bits.get_bit(i);
+          if (count_set_bits(bits, pos, n) != expected)
+            throw std::runtime_error("Wrong partial count");
+        }
+
+      for (size_t pos = 0, next = 0; pos <= len; ++pos) {
+        while (next < set.size() && set[next] < pos)
+          ++next;
+        if (find_next_set(bits, pos) != (next < set.size() ? set[next] : len))
+          throw std::runtime_error("Wrong next set bit");
+      }
+
+      std::vector<size_t> iterated;
+      for (auto i : set_bits{bits})
+        iterated.push_back(i);
+      if (iterated != set)
+        throw std::runtime_error("Wrong set bits iterated");
+    }
+  }
+
+  // Clearing must not set bits that were already clear
+  data buf{0b10100000};
+  bits_ref bits{buf};
+  bits.clear_bit(1);
+  bits.clear_bit(2);
+  if (buf[0] != 0b10000000)
+    throw std::runtime_error("clear_bit set a bit");
+  bits.toggle_bit(1);
+  bits.toggle_bit(0);
+  if (buf[0] != 0b01000000)
+    throw std::runtime_error("toggle_bit failed");
+
+  bit_datum<12> d;
+  d.clear_bit(3);
+  d.set_bit(4);
+  d.clear_bit(4);
+  d.toggle_bit(5);
+  if (d.get() != 1 << (12 - 5 - 1))
+    throw std::runtime_error("bit_datum clear_bit or toggle_bit failed");
+}
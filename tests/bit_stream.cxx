@@ -0,0 +1,101 @@
+#include "c3/nu/bits.hpp"
+#include "c3/nu/data.hpp"
+
+#include <random>
+
+using namespace c3::nu;
+
+int main() {
+  std::mt19937_64 rng{42};
+
+  // Widths from 0 to 64 in a random order, so that fields land on every alignment
+  std::vector<std::pair<n_bits_rep_t, uint64_t>> fields;
+  size_t total = 0;
+  for (size_t i = 0; i < 2000; ++i) {
+    auto n = static_cast<n_bits_rep_t>(rng() % 65);
+    auto value = n == 0 ? 0 : rng() >> (64 - n);
+    fields.emplace_back(n, value);
+    total += n;
+  }
+
+  data buf(divide_ceil<size_t>(total, CHAR_BIT), 0xa5);
+  {
+    bit_writer w{data_ref{buf}};
+    for (auto [n, value] : fields)
+      w.write(n, value);
+    if (w.position() != total)
+      throw std::runtime_error("Writer lost its place");
+  }
+
+  {
+    bits_const_ref b{buf};
+    size_t pos = 0;
+    for (auto [n, value] : fields) {
+      if (b.get_datum(pos, n).get() != value)
+        throw std::runtime_error("Writer disagreed with get_datum");
+      pos += n;
+    }
+    // The padding after the last field is left as it was
+    if (total % CHAR_BIT != 0 && b.get_datum(total, CHAR_BIT - total % CHAR_BIT).get() !=
+                                 (0xa5 & ((1u << (CHAR_BIT - total % CHAR_BIT)) - 1)))
+      throw std::runtime_error("Writer overwrote its padding");
+  }
+
+  {
+    bit_reader r{data_const_ref{buf}};
+    for (auto [n, value] : fields) {
+      if (r.peek(n) != value)
+        throw std::runtime_error("Peek disagreed with the writer");
+      if (r.read(n) != value)
+        throw std::runtime_error("Reader disagreed with the writer");
+    }
+    if (r.remaining() != buf.size() * CHAR_BIT - total)
+      throw std::runtime_error("Reader lost its place");
+    auto rest = static_cast<n_bits_rep_t>(r.remaining());
+    if (r.read(rest) != buf.back() % (1u << rest) || r.read(64) != 0 || r.read(7) != 0)
+      throw std::runtime_error("Reader read past the end");
+  }
+
+  {
+    bit_reader r{data_const_ref{buf}};
+    size_t pos = 0;
+    for (size_t i = 0; i < fields.size(); i += 2) {
+      r.skip(fields[i].first);
+      pos += fields[i].first;
+      if (r.read(fields[i + 1].first) != fields[i + 1].second)
+        throw std::runtime_error("Skip lost the reader's place");
+      pos += fields[i + 1].first;
+    }
+    if (r.position() != pos)
+      throw std::runtime_error("Skip lost the reader's place");
+  }
+
+  // Writing from an unaligned start keeps the bits before it
+  {
+    data out(8, 0xff);
+    {
+      bit_writer w{data_ref{out}, 3};
+      w.write<5>(0);
+      w.write(40, 0);
+      w.write(4, 0);
+    }
+    if (out != data{0xe0, 0, 0, 0, 0, 0, 0x0f, 0xff})
+      throw std::runtime_error("Unaligned writer corrupted its surroundings");
+  }
+
+  // bit_datum<Bits>::combine can start partway through its input
+  {
+    auto split = bit_datum<5>::split(serialise(std::string{"foobar"}));
+    data out(3);
+    bit_datum<5>::combine(split, out, 13);
+    auto expected = bits_const_ref{serialise(std::string{"foobar"})}.get_datum(13, 24).get();
+    if (bits_const_ref{out}.get_datum(0, 24).get() != expected)
+      throw std::runtime_error("Offset combine corrupted");
+
+    std::vector<bit_datum<dynamic_size>> dyn(split.begin(), split.end());
+    data dyn_out = bit_datum<dynamic_size>::combine(dyn, 5);
+    dyn_out.resize(6);
+    if (dyn_out != serialise(std::string{"foobar"}))
+      throw std::runtime_error("Dynamic combine corrupted");
+  }
+}
@@ -1,6 +1,8 @@
 #include "c3/nu/bits.hpp"
 #include "c3/nu/data.hpp"
 
+#include <algorithm>
+
 using namespace c3::nu;
 
 template<n_bits_rep_t Size>
@@ -16,7 +18,107 @@ auto check_one() {
     throw std::runtime_error("combine(split(msg)) != msg");
 }
 
+// Bit at a time, as get_datum and set_datum used to work
+uint64_t naive_get(bits_const_ref b, size_t pos, size_t n) {
+  uint64_t ret = 0;
+  for (size_t i = 0; i < n; ++i)
+    ret = (ret << 1) | (b.get_bit(pos + i) ? 1 : 0);
+  return ret;
+}
+
+void check_datum_access() {
+  uint64_t state = 0x2545f4914f6cdd1d;
+  auto next = [&] { state ^= state << 13; state ^= state >> 7; state ^= state << 17; return state; };
+
+  data buf(19);
+  for (auto& i : buf)
+    i = static_cast<uint8_t>(next());
+
+  // Odd lengths check that the bits past the end of the last byte are left alone
+  for (size_t len : {152, 150, 67, 8, 3}) {
+    bits_const_ref b{buf.data(), len};
+
+    for (n_bits_rep_t n = 0; n <= 64; ++n)
+      for (size_t pos = 0; pos < len + 2; ++pos)
+        if (b.get_datum(pos, n).get() != naive_get(b, pos, n))
+          throw std::runtime_error("get_datum disagreed with get_bit");
+
+    if (len > 4 && b.get_datum<6>(len - 4).get() != naive_get(b, len - 4, 6))
+      throw std::runtime_error("get_datum<6> disagreed with get_bit");
+  }
+
+  for (size_t len : {152, 150, 67}) {
+    for (n_bits_rep_t n = 1; n < 64; ++n) {
+      for (size_t pos = 0; pos < len; pos += 3) {
+        data out = buf;
+        bits_ref b{out.data(), len};
+        auto val = next() & (std::numeric_limits<uint64_t>::max() >> (64 - n));
+        b.set_datum(pos, bit_datum<dynamic_size>{val, n});
+
+        bits_const_ref orig{buf.data(), buf.size() * CHAR_BIT};
+        bits_const_ref now{out.data(), out.size() * CHAR_BIT};
+        for (size_t i = 0; i < buf.size() * CHAR_BIT; ++i) {
+          bool expected = i >= pos && i < pos + n && i < len ? (val >> (pos + n - 1 - i)) & 1 : orig.get_bit(i);
+          if (now.get_bit(i) != expected)
+            throw std::runtime_error("set_datum wrote the wrong bits");
+        }
+      }
+    }
+  }
+
+  if (bit_datum<6>{}.safe_set(0xff).get() != 0x3f || bit_datum<8>::all_set().get() != 0xff ||
+      bit_datum<dynamic_size>{6}.safe_set(0xff).get() != 0x3f)
+    throw std::runtime_error("Wrong datum mask");
+}
+
+// Long enough buffers to go through any SIMD kernel for Size, and every length of tail after them
+template<n_bits_rep_t Size>
+void check_bulk() {
+  uint64_t state = 0x9e3779b97f4a7c15;
+  auto next = [&] { state ^= state << 13; state ^= state >> 7; state ^= state << 17; return state; };
+
+  for (size_t len = 0; len < 160; ++len) {
+    data msg(len);
+    for (auto& i : msg)
+      i = static_cast<uint8_t>(next());
+
+    auto split_val = bit_datum<Size>::split(msg);
+    bits_const_ref b{msg};
+    for (size_t i = 0; i < split_val.size(); ++i)
+      if (split_val[i].get() != b.get_datum<Size>(i * Size).get())
+        throw std::runtime_error("split disagreed with get_datum");
+
+    // Anything past the combined bits is left alone
+    data combined_val(len + 20, 0x5a);
+    bit_datum<Size>::combine(split_val, combined_val);
+    if (!std::equal(msg.begin(), msg.end(), combined_val.begin()))
+      throw std::runtime_error("combine(split(msg)) != msg");
+    auto written = divide_ceil<size_t>(split_val.size() * Size, CHAR_BIT);
+    if (std::any_of(combined_val.begin() + static_cast<ssize_t>(written), combined_val.end(),
+                    [](auto i) { return i != 0x5a; }))
+      throw std::runtime_error("combine wrote past its data");
+
+    // Garbage above the datum's width is ignored
+    for (auto& i : split_val)
+      i.unsafe_set(static_cast<typename bit_datum<Size>::rep_t>(i.get() | ~bit_datum_rep<Size>::Mask));
+    data masked_val(msg.size());
+    bit_datum<Size>::combine(split_val, masked_val);
+    if (masked_val != msg)
+      throw std::runtime_error("combine used bits above the datum's width");
+  }
+}
+
 int main() {
+  check_datum_access();
+
+  check_bulk<3>();
+  check_bulk<4>();
+  check_bulk<5>();
+  check_bulk<6>();
+  check_bulk<7>();
+  check_bulk<12>();
+  check_bulk<13>();
+
   check_one<1>();
   check_one<2>();
   check_one<5>();
@@ -0,0 +1,91 @@
+#include "c3/nu/data/collections.hpp"
+
+using namespace c3::nu;
+
+template<typename T>
+bool borrows_from(const T& t, data_const_ref b) {
+  auto* ptr = reinterpret_cast<const uint8_t*>(t.data());
+  return ptr >= b.data() && ptr <= b.data() + b.size();
+}
+
+int main() {
+  std::string a = "foobar";
+  uint32_t b = 0x4a;
+  data c = {69, 180};
+  static_data<4> d = {1, 2, 3, 4};
+  std::vector<std::string> e = { "foo", "bar", "", "baz" };
+  std::vector<uint16_t> f = { 420, 69, 180 };
+
+  {
+    data buf = squash<uint16_t>(a, b, c);
+
+    std::string_view a_;
+    decltype(b) b_;
+    data_const_ref c_;
+    expand<uint16_t>(buf, a_, b_, c_);
+
+    if (a_ != a || b_ != b || !std::equal(c.begin(), c.end(), c_.begin(), c_.end()))
+      throw std::runtime_error("Borrowed expand corrupted");
+    if (!borrows_from(a_, buf) || !borrows_from(c_, buf))
+      throw std::runtime_error("expand copied");
+  }
+
+  {
+    data buf = squash_static(b, d);
+
+    decltype(b) b_;
+    gsl::span<const uint8_t, 4> d_{d.data(), 4};
+    expand_static(buf, b_, d_);
+
+    if (b_ != b || !std::equal(d.begin(), d.end(), d_.begin(), d_.end()))
+      throw std::runtime_error("Borrowed expand_static corrupted");
+    if (!borrows_from(d_, buf))
+      throw std::runtime_error("expand_static copied");
+  }
+
+  {
+    data buf = squash_seq<uint16_t>(e.begin(), e.end());
+
+    auto e_ = expand_seq<std::string_view, uint16_t>(buf);
+    if (!std::equal(e.begin(), e.end(), e_.begin(), e_.end()))
+      throw std::runtime_error("Borrowed expand_seq corrupted");
+    for (auto& i : e_)
+      if (!borrows_from(i, buf))
+        throw std::runtime_error("expand_seq copied");
+
+    seq_view<std::string_view, uint16_t> view{buf};
+    if (view.size() != e.size() || !std::equal(e.begin(), e.end(), view.begin(), view.end()))
+      throw std::runtime_error("Dynamic seq_view corrupted");
+  }
+
+  {
+    data buf = squash_seq(f.begin(), f.end());
+
+    seq_view<uint16_t> view{buf};
+    if (view.size() != f.size() || view[1] != f[1] || view.to_vector() != f)
+      throw std::runtime_error("Static seq_view corrupted");
+  }
+
+  {
+    // A view can itself be the target of expand
+    data seq = squash_seq<uint16_t>(e.begin(), e.end());
+    data buf = squash<uint16_t>(b, seq_view<std::string_view, uint16_t>{seq}, a);
+
+    decltype(b) b_;
+    seq_view<std::string_view, uint16_t> view;
+    std::string_view a_;
+    expand<uint16_t>(buf, b_, view, a_);
+
+    if (b_ != b || a_ != a || !std::equal(e.begin(), e.end(), view.begin(), view.end()))
+      throw std::runtime_error("Nested seq_view corrupted");
+  }
+
+  {
+    data bad = { 0, 5, 'a' };
+    bool threw = false;
+    try { seq_view<std::string_view, uint16_t> view{bad}; }
+    catch (std::exception&) { threw = true; }
+    if (!threw)
+      throw std::runtime_error("Truncated seq_view not detected");
+  }
+}
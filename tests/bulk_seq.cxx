@@ -0,0 +1,63 @@
+#include "c3/nu/data/collections.hpp"
+
+#include <list>
+#include <random>
+
+using namespace c3::nu;
+
+template<typename T>
+void check_round_trip(size_t n) {
+  std::mt19937_64 rng{n};
+  std::vector<T> a(n);
+  for (auto& i : a)
+    i = static_cast<T>(rng());
+
+  // A list is not contiguous, so goes element by element
+  std::list<T> a_list(a.begin(), a.end());
+  data expected = squash_seq(a_list.begin(), a_list.end());
+
+  data buf = squash_seq(a.begin(), a.end());
+  if (buf != expected)
+    throw std::runtime_error("Bulk squash_seq corrupted");
+
+  const T* ptr = a.data();
+  if (squash_seq(ptr, ptr + a.size()) != expected)
+    throw std::runtime_error("Bulk squash_seq from pointers corrupted");
+
+  if (expand_seq<T>(buf) != a)
+    throw std::runtime_error("Bulk expand_seq corrupted");
+
+  // The serialised form must not depend on where the data starts
+  data offset(buf.size() + 1);
+  std::copy(buf.begin(), buf.end(), offset.begin() + 1);
+  if (expand_seq<T>(data_const_ref{offset}.subspan(1)) != a)
+    throw std::runtime_error("Unaligned bulk expand_seq corrupted");
+}
+
+template<typename T>
+void check_all() {
+  for (size_t n : { 0, 1, 3, 15, 16, 17, 1000, 1027 })
+    check_round_trip<T>(n);
+}
+
+int main() {
+  static_assert(is_contiguous_iter_v<std::vector<uint32_t>::iterator>);
+  static_assert(is_contiguous_iter_v<std::string::const_iterator>);
+  static_assert(is_contiguous_iter_v<const uint16_t*>);
+  static_assert(!is_contiguous_iter_v<std::list<uint32_t>::iterator>);
+  static_assert(!is_contiguous_iter_v<std::vector<bool>::iterator>);
+
+  check_all<uint8_t>();
+  check_all<int8_t>();
+  check_all<uint16_t>();
+  check_all<int16_t>();
+  check_all<uint32_t>();
+  check_all<int32_t>();
+  check_all<uint64_t>();
+  check_all<int64_t>();
+
+  // The format itself must be big-endian
+  std::vector<uint32_t> b = { 0x01020304, 0x05060708 };
+  if (squash_seq(b.begin(), b.end()) != data{1, 2, 3, 4, 5, 6, 7, 8})
+    throw std::runtime_error("Bulk squash_seq is not big-endian");
+}
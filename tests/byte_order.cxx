@@ -0,0 +1,120 @@
+#include "c3/nu/data/collections.hpp"
+#include "c3/nu/data/helpers.hpp"
+
+using namespace c3::nu;
+
+enum class colour : uint16_t { red = 0x0102, green = 0x0304 };
+
+struct sample {
+  uint32_t id;
+  uint16_t value;
+  uint8_t flags;
+  uint8_t channel;
+
+  C3_NU_FIELDS(id, value, flags, channel)
+};
+
+template<typename T>
+data raw_bytes(const T* t, size_t n = 1) {
+  auto* ptr = reinterpret_cast<const uint8_t*>(t);
+  return { ptr, ptr + sizeof(T) * n };
+}
+
+int main() {
+  uint32_t a = 0x01020304;
+  colour b = colour::green;
+  std::array<uint16_t, 2> c = { 0x0506, 0x0708 };
+
+  {
+    data buf(4);
+    serialise_static<uint32_t, byte_order::little>(a, buf);
+    if (buf != data{4, 3, 2, 1} || deserialise<uint32_t, byte_order::little>(buf) != a)
+      throw std::runtime_error("Little-endian integer corrupted");
+
+    serialise_static<uint32_t, byte_order::native>(a, buf);
+    if (buf != raw_bytes(&a) || deserialise<uint32_t, byte_order::native>(buf) != a)
+      throw std::runtime_error("Native integer corrupted");
+
+    if (deserialise<uint32_t, byte_order::big>(serialise(a)) != a)
+      throw std::runtime_error("Explicit big-endian integer corrupted");
+  }
+
+  {
+    data buf = squash_static<byte_order::little>(a, b, c);
+    if (buf != data{4, 3, 2, 1, 4, 3, 6, 5, 8, 7})
+      throw std::runtime_error("Little-endian squash_static corrupted");
+
+    decltype(a) a_;
+    decltype(b) b_;
+    decltype(c) c_;
+    expand_static<byte_order::little>(buf, a_, b_, c_);
+    if (a_ != a || b_ != b || c_ != c)
+      throw std::runtime_error("Little-endian expand_static corrupted");
+
+    if (squash_static<byte_order::big>(a, b, c) != squash_static(a, b, c))
+      throw std::runtime_error("Default byte order changed");
+  }
+
+  {
+    std::string d = "foobar";
+    data buf = squash<uint16_t, byte_order::little>(d, a, d);
+    data expected = { 6, 0, 'f', 'o', 'o', 'b', 'a', 'r', 4, 3, 2, 1, 'f', 'o', 'o', 'b', 'a', 'r' };
+    if (buf != expected)
+      throw std::runtime_error("Little-endian squash corrupted");
+
+    std::string d_0, d_1;
+    decltype(a) a_;
+    expand<uint16_t, byte_order::little>(buf, d_0, a_, d_1);
+    if (d_0 != d || a_ != a || d_1 != d)
+      throw std::runtime_error("Little-endian expand corrupted");
+  }
+
+  {
+    std::vector<uint32_t> e = { 1, 0x01020304, 0xffffffff, 420, 69 };
+    for (size_t i = 0; i < 100; ++i)
+      e.push_back(static_cast<uint32_t>(i * 0x01010101));
+
+    // Native order is just the in-memory representation
+    data buf = squash_seq<byte_order::native>(e.begin(), e.end());
+    if (buf != raw_bytes(e.data(), e.size()))
+      throw std::runtime_error("Native squash_seq is not a copy");
+    if (expand_seq<uint32_t, byte_order::native>(buf) != e)
+      throw std::runtime_error("Native expand_seq corrupted");
+
+    buf = squash_seq<byte_order::little>(e.begin(), e.end());
+    if (buf[4] != 4 || buf[7] != 1 || expand_seq<uint32_t, byte_order::little>(buf) != e)
+      throw std::runtime_error("Little-endian squash_seq corrupted");
+
+    std::vector<colour> f = { colour::red, colour::green };
+    buf = squash_seq<byte_order::little>(f.begin(), f.end());
+    if (buf != data{2, 1, 4, 3} || expand_seq<colour, byte_order::little>(buf) != f)
+      throw std::runtime_error("Little-endian enum sequence corrupted");
+  }
+
+  {
+    std::vector<std::string> g = { "foo", "bar", "", "wibble" };
+    data buf = squash_seq<uint16_t, byte_order::little>(g.begin(), g.end());
+    if (buf[0] != 3 || buf[1] != 0)
+      throw std::runtime_error("Little-endian prefix incorrect");
+    if (expand_seq<std::string, uint16_t, byte_order::little>(buf) != g)
+      throw std::runtime_error("Little-endian dynamic sequence corrupted");
+  }
+
+  {
+    sample h = { 0x01020304, 0x0506, 7, 8 };
+    data buf(serialised_size<sample>());
+    serialise_static<sample, byte_order::native>(h, buf);
+    if (buf != raw_bytes(&h))
+      throw std::runtime_error("Native fields are not a copy");
+
+    serialise_static<sample, byte_order::little>(h, buf);
+    if (buf != data{4, 3, 2, 1, 6, 5, 7, 8})
+      throw std::runtime_error("Little-endian fields corrupted");
+
+    auto h_ = deserialise<sample, byte_order::little>(buf);
+    if (h_.id != h.id || h_.value != h.value || h_.flags != h.flags || h_.channel != h.channel)
+      throw std::runtime_error("Little-endian fields could not be deserialised");
+  }
+}
+
+#include "c3/nu/data/clean_helpers.hpp"
@@ -0,0 +1,26 @@
+#include "c3/nu/data/checksum.hpp"
+
+#include <string_view>
+
+using namespace c3::nu;
+
+data_const_ref as_bytes(std::string_view str) {
+  return { reinterpret_cast<const uint8_t*>(str.data()), static_cast<data_const_ref::size_type>(str.size()) };
+}
+
+int main() {
+  // Reference values from RFC 3720
+  if (crc32c(as_bytes("123456789")) != 0xe3069283)
+    throw std::runtime_error("CRC32C check value incorrect");
+  if (crc32c(data(32, 0)) != 0x8a9136aa || crc32c(data(32, 0xff)) != 0x62a8ab43)
+    throw std::runtime_error("CRC32C reference values incorrect");
+  if (crc32c(data{}) != 0)
+    throw std::runtime_error("CRC32C of nothing incorrect");
+
+  // Continuing a CRC must match doing it all at once, whatever the split
+  std::string_view text = "The quick brown fox jumps over the lazy dog, repeatedly and at length";
+  auto whole = crc32c(as_bytes(text));
+  for (size_t i = 0; i <= text.size(); ++i)
+    if (crc32c(as_bytes(text.substr(i)), crc32c(as_bytes(text.substr(0, i)))) != whole)
+      throw std::runtime_error("Continued CRC32C incorrect");
+}
@@ -0,0 +1,97 @@
+#include "c3/nu/data/encoders/compression.hpp"
+#include "c3/nu/data/collections/sequence.hpp"
+
+#include <random>
+
+using namespace c3::nu;
+
+void check_round_trip(const data& in) {
+  data compressed = compress_data(in);
+  if (decompress_data(compressed) != in)
+    throw std::runtime_error("Compressed round trip corrupted");
+  if (compressed.size() > varint_len(in.size()) + compress_block_bound(in.size()))
+    throw std::runtime_error("Compressed data exceeded its bound");
+
+  if (decompress_stream(compress_stream(in)) != in)
+    throw std::runtime_error("Compressed stream round trip corrupted");
+}
+
+int main() {
+  std::mt19937_64 rng;
+
+  data random(200000);
+  for (auto& i : random)
+    i = static_cast<uint8_t>(rng());
+
+  std::vector<uint32_t> seq(50000);
+  for (size_t i = 0; i < seq.size(); ++i)
+    seq[i] = static_cast<uint32_t>(i % 1000);
+  data repetitive = squash_seq(seq.begin(), seq.end());
+
+  std::string text;
+  for (size_t i = 0; i < 5000; ++i)
+    text += "{\"host\":\"web-0" + std::to_string(rng() % 4) + "\",\"value\":" + std::to_string(rng() % 100) + "}";
+  data text_data(text.begin(), text.end());
+
+  for (size_t n = 0; n < 40; ++n)
+    check_round_trip(data(random.begin(), random.begin() + static_cast<ssize_t>(n)));
+  check_round_trip(data(100000, 'a'));
+  check_round_trip(random);
+  check_round_trip(repetitive);
+  check_round_trip(text_data);
+
+  if (compress_data(repetitive).size() * 4 > repetitive.size() || compress_data(text_data).size() * 2 > text_data.size())
+    throw std::runtime_error("Compression did not shrink repetitive data");
+
+  if (decompress<std::string>(compress(text)) != text)
+    throw std::runtime_error("Typed compressed round trip corrupted");
+
+  // A stream fed in awkward pieces, with the output taken as it arrives
+  data stream = compress_stream(text_data);
+  decompressor d;
+  data out;
+  for (size_t pos = 0; pos < stream.size(); pos += 777) {
+    auto piece = data_const_ref{stream}.subspan(static_cast<data_const_ref::index_type>(pos));
+    d.feed(piece.subspan(0, std::min<data_const_ref::index_type>(777, piece.size())));
+    auto got = d.take();
+    out.insert(out.end(), got.begin(), got.end());
+  }
+  auto rest = d.finish();
+  out.insert(out.end(), rest.begin(), rest.end());
+  if (out != text_data)
+    throw std::runtime_error("Piecewise decompression corrupted");
+
+  // Incompressible chunks are stored, so a stream never grows much
+  if (compress_stream(random).size() > random.size() + 64)
+    throw std::runtime_error("Compressed stream grew incompressible data");
+
+  // Corrupt inputs must throw rather than read or write out of bounds
+  auto compressed = compress_data(text_data);
+  for (size_t i = 0; i < 2000; ++i) {
+    auto bad = compressed;
+    bad[rng() % bad.size()] ^= static_cast<uint8_t>(1 << (rng() % 8));
+    if (i % 2)
+      bad.resize(rng() % bad.size());
+    try {
+      // A flip may land in literals, which decompresses fine to the wrong thing
+      decompress_data(bad);
+    }
+    catch (const serialisation_failure&) {}
+  }
+
+  decompressor early;
+  early.feed(data_const_ref{stream}.subspan(0, static_cast<data_const_ref::index_type>(stream.size() - 1)));
+  try {
+    early.finish();
+    throw std::runtime_error("Truncated stream was accepted");
+  }
+  catch (const serialisation_failure&) {}
+
+  auto trailing = stream;
+  trailing.push_back(0);
+  try {
+    decompress_stream(trailing);
+    throw std::runtime_error("Data after the end of a stream was accepted");
+  }
+  catch (const serialisation_failure&) {}
+}
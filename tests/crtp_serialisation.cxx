@@ -0,0 +1,116 @@
+#include "c3/nu/data/collections.hpp"
+#include "c3/nu/data/helpers.hpp"
+
+using namespace c3;
+
+class type_0 : public nu::crtp_static_serialisable<type_0> {
+public:
+  uint32_t bob;
+
+public:
+  type_0() = default;
+  type_0(uint32_t bob) : bob{bob} {}
+  bool operator==(const type_0& other) const { return bob == other.bob; }
+
+public:
+  C3_NU_DEFER_CRTP_STATIC_SERIALISATION_VAR(type_0, bob)
+};
+
+class type_1 : public nu::crtp_static_serialisable<type_1> {
+public:
+  uint16_t bob;
+
+public:
+  type_1() = default;
+  type_1(uint16_t bob) : bob{bob} {}
+  operator uint16_t() const { return bob; }
+
+public:
+  C3_NU_DEFER_CRTP_STATIC_SERIALISATION_TYPE(type_1, uint16_t)
+};
+
+class type_2 : public nu::crtp_serialisable<type_2> {
+public:
+  std::string bob;
+
+public:
+  type_2() = default;
+  type_2(std::string bob) : bob{std::move(bob)} {}
+
+public:
+  C3_NU_DEFER_CRTP_SERIALISATION_VAR(type_2, bob)
+};
+
+class type_3 : public nu::crtp_static_serialisable<type_3> {
+public:
+  uint16_t bob;
+  uint16_t alice;
+
+private:
+  void _serialise_static(nu::data_ref b) const {
+    nu::squash_static_unsafe(b, bob, alice);
+  }
+
+public:
+  C3_NU_DEFINE_CRTP_STATIC_DESERIALISE(type_3, 4, b) {
+    type_3 ret;
+    nu::expand_static(b, ret.bob, ret.alice);
+    return ret;
+  }
+};
+
+class type_4 : public nu::crtp_serialisable<type_4> {
+public:
+  std::string bob;
+
+private:
+  nu::data _serialise() const { return nu::serialise(bob); }
+
+public:
+  C3_NU_DEFINE_CRTP_DESERIALISE(type_4, b) {
+    type_4 ret;
+    ret.bob = nu::deserialise<std::string>(b);
+    return ret;
+  }
+};
+
+int main() {
+  // No vtable pointers
+  static_assert(!std::is_polymorphic_v<type_0> && sizeof(type_0) == sizeof(uint32_t));
+  static_assert(!std::is_polymorphic_v<type_2>);
+  static_assert(nu::serialised_size<type_0>() == 4);
+  static_assert(nu::serialised_size<type_3>() == 4);
+  static_assert(nu::is_static_serialisable_v<type_1>);
+
+  std::vector<type_0> a = { 420, 69, 180 };
+  auto a_ = nu::expand_seq<type_0>(nu::squash_seq(a.begin(), a.end()));
+  if (a != a_)
+    throw std::runtime_error("CRTP static sequence corrupted");
+
+  if (nu::serialise(a[0]) != nu::serialise(uint32_t{420}))
+    throw std::runtime_error("CRTP static format changed");
+
+  type_1 b = 0x4a;
+  type_2 c{"foobar"};
+  type_3 d;
+  d.bob = 1;
+  d.alice = 2;
+  type_4 e;
+  e.bob = "wibble";
+
+  if (nu::serialised_size_of(c) != c.bob.size() || nu::serialised_size_of(e) != e.bob.size())
+    throw std::runtime_error("CRTP serialised_size_of incorrect");
+
+  auto buf = nu::squash<uint16_t>(c, b, d, e);
+
+  type_1 b_;
+  type_2 c_;
+  type_3 d_;
+  type_4 e_;
+  nu::expand<uint16_t>(buf, c_, b_, d_, e_);
+
+  if (b_ != b || c_.bob != c.bob || d_.bob != d.bob || d_.alice != d.alice || e_.bob != e.bob)
+    throw std::runtime_error("CRTP hybrid collection corrupted");
+}
+
+#include "c3/nu/data/clean_helpers.hpp"
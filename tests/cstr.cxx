@@ -11,4 +11,9 @@ int main() {
   std::cout << buf << std::endl;
   if (cstr_decode(buf) != str)
     throw std::runtime_error("Failed to decode string");
+
+  // High bytes are negative as chars, but must still come out as three octal digits
+  std::string high = "a\xff\x80" "b";
+  if (cstr_encode(high) != R"(a\377\200b)" || cstr_decode(cstr_encode(high)) != high)
+    throw std::runtime_error("Failed to encode high bytes");
 }
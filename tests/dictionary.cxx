@@ -0,0 +1,75 @@
+#include "c3/nu/data/collections.hpp"
+
+#include <list>
+#include <random>
+
+using namespace c3::nu;
+
+template<typename SizeType, byte_order Order = byte_order::big>
+void check_round_trip(const std::vector<std::string>& a) {
+  data buf = squash_dict<SizeType, Order>(a.begin(), a.end());
+  if (expand_dict<SizeType, Order>(buf) != a)
+    throw std::runtime_error("Dictionary round trip corrupted");
+
+  dict_view<SizeType, Order> view{buf};
+  if (view.size() != a.size())
+    throw std::runtime_error("Dictionary view has the wrong size");
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (view[i] != a[i] || view.dictionary()[view.code(i)] != a[i])
+      throw std::runtime_error("Dictionary view corrupted");
+    // The strings are borrowed from the buffer
+    if (!a[i].empty() && (reinterpret_cast<const uint8_t*>(view[i].data()) < buf.data() ||
+                          reinterpret_cast<const uint8_t*>(view[i].data()) >= buf.data() + buf.size()))
+      throw std::runtime_error("Dictionary view copied a string");
+  }
+}
+
+int main() {
+  std::vector<std::string> hosts = { "web-01.example.com", "web-02.example.com", "db-01.example.com", "" };
+  std::vector<std::string> labels(5000);
+  std::mt19937_64 rng;
+  for (auto& i : labels)
+    i = hosts[rng() % hosts.size()];
+
+  for (auto& a : { std::vector<std::string>{}, std::vector<std::string>{ "" }, hosts, labels }) {
+    check_round_trip<varint>(a);
+    check_round_trip<uint16_t>(a);
+    check_round_trip<uint32_t, byte_order::little>(a);
+  }
+
+  // Distinct strings appear once each, in order of first appearance
+  data labels_buf = squash_dict(labels.begin(), labels.end());
+  dict_view<> view{labels_buf};
+  if (view.dictionary().size() != hosts.size() || view.dictionary()[0] != labels[0])
+    throw std::runtime_error("Dictionary has the wrong entries");
+
+  data plain = squash_seq<varint>(labels.begin(), labels.end());
+  if (labels_buf.size() * 8 > plain.size())
+    throw std::runtime_error("Dictionary did not shrink repetitive labels");
+
+  // Views into other storage work just as well
+  std::vector<std::string_view> views(labels.begin(), labels.end());
+  std::list<std::string_view> view_list(views.begin(), views.end());
+  if (squash_dict(view_list.begin(), view_list.end()) != squash_dict(labels.begin(), labels.end()))
+    throw std::runtime_error("Dictionary depends on the string type");
+
+  // Corrupt inputs
+  auto check_throws = [](data_const_ref b) {
+    try { dict_view<> v{b}; }
+    catch (const std::exception&) { return; }
+    throw std::runtime_error("Corrupt dictionary was accepted");
+  };
+  auto buf = squash_dict(hosts.begin(), hosts.end());
+  for (size_t len : { size_t{0}, size_t{1}, size_t{5}, buf.size() / 2, buf.size() - 1 })
+    check_throws(data_const_ref{buf}.subspan(0, static_cast<data_const_ref::index_type>(len)));
+  auto bad_entries = buf;
+  bad_entries[0] = 100;
+  check_throws(bad_entries);
+
+  // A code past the end of the dictionary
+  std::vector<uint32_t> codes = { 0, 1, 2 };
+  data bad_code = { 2, 1, 'a', 1, 'b' };
+  auto packed = squash_packed(codes.begin(), codes.end());
+  bad_code.insert(bad_code.end(), packed.begin(), packed.end());
+  check_throws(bad_code);
+}
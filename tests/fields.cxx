@@ -0,0 +1,96 @@
+#include "c3/nu/data/collections.hpp"
+#include "c3/nu/data/helpers.hpp"
+
+using namespace c3::nu;
+
+enum class state : uint16_t { idle = 0, busy = 0x4a };
+
+struct telemetry {
+  uint64_t timestamp;
+  uint32_t id;
+  state status;
+  uint8_t flags;
+  uint8_t channel;
+
+  bool operator==(const telemetry& other) const {
+    return timestamp == other.timestamp && id == other.id && status == other.status &&
+           flags == other.flags && channel == other.channel;
+  }
+
+  C3_NU_FIELDS(timestamp, id, status, flags, channel)
+};
+
+struct bytes {
+  uint8_t a;
+  int8_t b;
+  static_data<4> c;
+
+  C3_NU_FIELDS(a, b, c)
+};
+
+struct padded {
+  uint8_t a;
+  uint32_t b;
+  uint16_t c;
+
+  C3_NU_FIELDS(a, b, c)
+};
+
+int main() {
+  static_assert(serialised_size<telemetry>() == 16);
+  static_assert(serialised_size<bytes>() == 6);
+  static_assert(serialised_size<padded>() == 7);
+  static_assert(is_static_serialisable_v<telemetry>);
+
+  telemetry a = { 0x0102030405060708, 420, state::busy, 69, 180 };
+  if (serialise(a) != squash_static(a.timestamp, a.id, a.status, a.flags, a.channel))
+    throw std::runtime_error("Field serialisation format incorrect");
+  if (!(deserialise<telemetry>(serialise(a)) == a))
+    throw std::runtime_error("Field serialisation corrupted");
+
+  // telemetry is packed, so is copied whole and has its integers swapped in place, whatever the host's byte order
+  if (!_fields_are_packed(a))
+    throw std::runtime_error("Packed struct not copied whole");
+  {
+    auto serialise_as = [](byte_order order, auto t) {
+      data ret(serialised_size<decltype(t)>());
+      if (order == byte_order::little)
+        serialise_static<decltype(t), byte_order::little>(t, ret);
+      else
+        serialise_static<decltype(t), byte_order::big>(t, ret);
+      return ret;
+    };
+
+    data le = serialise_as(byte_order::little, a);
+    data expected;
+    for (auto field : { serialise_as(byte_order::little, a.timestamp), serialise_as(byte_order::little, a.id),
+                        serialise_as(byte_order::little, a.status), data{a.flags, a.channel} })
+      expected.insert(expected.end(), field.begin(), field.end());
+    if (le != expected || !(deserialise<telemetry, byte_order::little>(le) == a))
+      throw std::runtime_error("Little-endian field serialisation corrupted");
+  }
+
+  bytes b = { 1, -2, { 3, 4, 5, 6 } };
+  auto b_ = deserialise<bytes>(serialise(b));
+  if (serialise(b) != data{1, 0xfe, 3, 4, 5, 6} || b_.a != b.a || b_.b != b.b || b_.c != b.c)
+    throw std::runtime_error("Byte field serialisation corrupted");
+
+  padded c = { 69, 0x01020304, 420 };
+  auto c_ = deserialise<padded>(serialise(c));
+  if (serialise(c) != squash_static(c.a, c.b, c.c) || c_.a != c.a || c_.b != c.b || c_.c != c.c)
+    throw std::runtime_error("Padded field serialisation corrupted");
+
+  // Structs with fields compose like any other static type
+  std::vector<telemetry> d = { a, a, a };
+  d[1].id = 69;
+  if (expand_seq<telemetry>(squash_seq(d.begin(), d.end())) != d)
+    throw std::runtime_error("Field sequence corrupted");
+
+  bool threw = false;
+  try { deserialise<telemetry>(data(15)); }
+  catch (serialisation_failure&) { threw = true; }
+  if (!threw)
+    throw std::runtime_error("Truncated fields not detected");
+}
+
+#include "c3/nu/data/clean_helpers.hpp"
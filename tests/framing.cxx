@@ -0,0 +1,92 @@
+#include "c3/nu/data/framing.hpp"
+#include "c3/nu/data/collections/sequence.hpp"
+
+#include <string>
+
+using namespace c3::nu;
+
+int main() {
+  std::string str = "Lorem ipsum dolor sit amet";
+  std::vector<uint64_t> nums = { 1, 2, 3, 0xdeadbeef };
+
+  // The running checksum matches checksumming the output afterwards, however it was written
+  data out;
+  data_sink sink{out};
+  checksum_sink<data_sink> cs{sink};
+  squash_into<uint16_t>(cs, str, uint32_t{42}, str);
+  serialise_into(str, cs);
+  cs.append_borrowed(data_const_ref{out}.subspan(0, 4));
+  squash_seq_into(cs, nums.begin(), nums.end());
+  if (cs.crc() != crc32c(out) || cs.size() != out.size())
+    throw std::runtime_error("checksum_sink disagreed with crc32c");
+
+  {
+    // Reserving past the capacity moves the bytes still to be checksummed
+    data moved;
+    data_sink moved_sink{moved};
+    checksum_sink<data_sink> moved_cs{moved_sink};
+    serialise_static(uint32_t{0xdeadbeef}, moved_cs.claim(4));
+    moved_cs.reserve(moved.capacity() + 4096);
+    squash_seq_into<uint16_t>(moved_cs, &str, &str + 1);
+    if (moved_cs.crc() != crc32c(moved))
+      throw std::runtime_error("checksum_sink lost claimed bytes on reserve");
+  }
+
+  gather_sink gather;
+  checksum_sink<gather_sink> gather_cs{gather};
+  // Long enough to be borrowed rather than copied
+  std::string long_str(1000, 'x');
+  squash_into<uint16_t>(gather_cs, str, long_str, str);
+  if (gather_cs.crc() != crc32c(gather.flatten()))
+    throw std::runtime_error("checksum_sink over a gather_sink disagreed with crc32c");
+
+  {
+    // The payload ends on a claim, which framing must checksum before claiming room for the CRC
+    gather_sink framed;
+    squash_framed_into<uint16_t>(framed, long_str, uint32_t{42});
+    auto flat = framed.flatten();
+    std::string x;
+    uint32_t y;
+    expand<uint16_t>(unframe(flat), x, y);
+    if (x != long_str || y != 42)
+      throw std::runtime_error("Framing into a gather_sink corrupted");
+  }
+
+  // Round trips
+  data frame = serialise_framed(str);
+  if (frame.size() != str.size() + frame_overhead || deserialise<std::string>(unframe(frame)) != str)
+    throw std::runtime_error("Framed round trip corrupted");
+  if (unframe(serialise_framed(std::string{})).size() != 0)
+    throw std::runtime_error("Empty frame corrupted");
+
+  data squashed = squash_framed<uint16_t>(str, uint32_t{42}, str);
+  std::string a, c;
+  uint32_t b;
+  expand<uint16_t>(unframe(squashed), a, b, c);
+  if (a != str || b != 42 || c != str)
+    throw std::runtime_error("Framed squash round trip corrupted");
+
+  // A stream of frames can be read one by one
+  data stream = frame;
+  stream.insert(stream.end(), squashed.begin(), squashed.end());
+  data_const_ref rest = stream;
+  if (deserialise<std::string>(read_frame(rest)) != str || read_frame(rest).size() + frame_overhead != squashed.size() ||
+      rest.size() != 0)
+    throw std::runtime_error("Reading a stream of frames failed");
+
+  // Corruption anywhere is caught
+  auto check_throws = [](data_const_ref b) {
+    try { unframe(b); }
+    catch (const serialisation_failure&) { return; }
+    throw std::runtime_error("Corrupt frame was accepted");
+  };
+  for (size_t i = 0; i < frame.size(); ++i) {
+    auto bad = frame;
+    bad[i] ^= 0x10;
+    check_throws(bad);
+    check_throws(data_const_ref{frame}.subspan(0, static_cast<data_const_ref::index_type>(i)));
+  }
+  auto spare = frame;
+  spare.push_back(0);
+  check_throws(spare);
+}
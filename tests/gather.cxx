@@ -0,0 +1,75 @@
+#include "c3/nu/data/collections.hpp"
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace c3::nu;
+
+int main() {
+  std::string a(4096, 'x');
+  uint32_t b = 0x4a;
+  data c(1024, 0x69);
+  std::string d = "tiny";
+  std::string e(512, 'y');
+
+  gather_sink sink;
+  squash_into<uint32_t>(sink, a, b, c, d, e);
+
+  data expected = squash<uint32_t>(a, b, c, d, e);
+  if (sink.size() != expected.size() || sink.flatten() != expected)
+    throw std::runtime_error("Gathered output corrupted");
+
+  // The large fields must be referenced, not copied
+  auto segments = sink.segments();
+  auto references = [&](const auto& buf) {
+    for (auto i : segments)
+      if (reinterpret_cast<const void*>(i.data()) == reinterpret_cast<const void*>(buf.data()))
+        return true;
+    return false;
+  };
+  if (!references(a) || !references(c) || !references(e) || references(d))
+    throw std::runtime_error("gather_sink copied the wrong fields");
+
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    throw std::runtime_error("Could not create socketpair");
+
+  auto iov = sink.iovecs();
+  auto n_written = ::writev(fds[0], iov.data(), static_cast<int>(iov.size()));
+  if (n_written != static_cast<ssize_t>(expected.size()))
+    throw std::runtime_error("Short writev");
+  ::close(fds[0]);
+
+  data received;
+  while (true) {
+    uint8_t buf[1024];
+    auto n_read = ::read(fds[1], buf, sizeof(buf));
+    if (n_read < 0)
+      throw std::runtime_error("Read failed");
+    if (n_read == 0)
+      break;
+    received.insert(received.end(), buf, buf + n_read);
+  }
+  ::close(fds[1]);
+
+  if (received != expected)
+    throw std::runtime_error("Received data corrupted");
+
+  std::string_view a_;
+  decltype(b) b_;
+  data_const_ref c_;
+  std::string d_;
+  std::string_view e_;
+  expand<uint32_t>(received, a_, b_, c_, d_, e_);
+  if (a_ != a || b_ != b || !std::equal(c.begin(), c.end(), c_.begin(), c_.end()) || d_ != d || e_ != e)
+    throw std::runtime_error("Received data could not be expanded");
+
+  gather_sink all;
+  serialise_all_into(all, b, a, d);
+  data all_expected = serialise(b);
+  all_expected.insert(all_expected.end(), a.begin(), a.end());
+  all_expected.insert(all_expected.end(), d.begin(), d.end());
+  if (all.flatten() != all_expected)
+    throw std::runtime_error("serialise_all_into corrupted");
+}
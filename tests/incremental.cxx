@@ -0,0 +1,126 @@
+#include "c3/nu/data/collections.hpp"
+
+#include <random>
+
+using namespace c3::nu;
+
+template<typename Decoder>
+void feed_in_chunks(Decoder& dec, data_const_ref b, size_t seed) {
+  std::mt19937 rng{static_cast<uint32_t>(seed)};
+  while (b.size() > 0) {
+    // seed 0 feeds a byte at a time, to hit every boundary
+    size_t n = seed == 0 ? 1 : std::uniform_int_distribution<size_t>{1, 64}(rng);
+    n = std::min<size_t>(n, b.size());
+    dec.feed(b.subspan(0, n));
+    b = b.subspan(n);
+  }
+}
+
+template<typename F>
+void check_throws(F f, const char* msg) {
+  bool threw = false;
+  try { f(); }
+  catch (serialisation_failure&) { threw = true; }
+  if (!threw)
+    throw std::runtime_error(msg);
+}
+
+template<typename SizeType>
+void check_hybrid() {
+  std::string a = "foobar";
+  uint32_t b = 0x4a;
+  data c(300, 0x69);
+  std::string d = "";
+  std::string e = "wibble";
+
+  data buf = squash<SizeType>(a, b, c, d, e);
+
+  for (size_t seed = 0; seed < 8; ++seed) {
+    incremental_expand<SizeType, std::string, uint32_t, data, std::string, std::string> dec;
+    if (dec.need() != size_prefix<SizeType>::min_len)
+      throw std::runtime_error("Incorrect initial need");
+
+    feed_in_chunks(dec, buf, seed);
+    // The final element is not prefixed, so it could go on
+    if (dec.done() || dec.n_done() != 4)
+      throw std::runtime_error("Incremental expand ended early");
+
+    dec.finish();
+    auto [a_, b_, c_, d_, e_] = dec.take();
+    if (a_ != a || b_ != b || c_ != c || d_ != d || e_ != e)
+      throw std::runtime_error("Incremental expand corrupted");
+  }
+
+  // All static, so it knows when it is done
+  data static_buf = squash<SizeType>(b, uint16_t{420}, b);
+  incremental_expand<SizeType, uint32_t, uint16_t, uint32_t> static_dec;
+  static_dec.feed(data_const_ref{static_buf}.subspan(0, 5));
+  if (static_dec.need() != 1 || static_dec.n_done() != 1)
+    throw std::runtime_error("Incorrect static need");
+  static_dec.feed(data_const_ref{static_buf}.subspan(5));
+  if (!static_dec.done() || std::get<1>(static_dec.get()) != 420)
+    throw std::runtime_error("Incremental static expand corrupted");
+
+  check_throws([&] { static_dec.feed(static_buf); }, "Trailing data not detected");
+
+  incremental_expand<SizeType, std::string, std::string> short_dec;
+  short_dec.feed(data_const_ref{buf}.subspan(0, 4));
+  check_throws([&] { short_dec.finish(); }, "Truncated input not detected");
+}
+
+int main() {
+  // Decoders reject these, as the chunks they would borrow from are not kept
+  static_assert(borrows_from_input_v<std::string_view> && borrows_from_input_v<data_const_ref> &&
+                borrows_from_input_v<gsl::span<const uint8_t, 4>> &&
+                borrows_from_input_v<seq_view<std::string, uint16_t>>);
+  static_assert(!borrows_from_input_v<std::string> && !borrows_from_input_v<data> &&
+                !borrows_from_input_v<static_data<4>> && !borrows_from_input_v<uint32_t>);
+
+  check_hybrid<uint16_t>();
+  check_hybrid<varint>();
+
+  {
+    std::vector<std::string> a = { "foo", "", std::string(1000, 'x'), "bar", "baz" };
+    data buf = squash_seq<varint>(a.begin(), a.end());
+
+    for (size_t seed = 0; seed < 8; ++seed) {
+      incremental_expand_seq<std::string, varint> dec;
+      std::vector<std::string> a_;
+
+      // Take elements as they arrive
+      data_const_ref rest = buf;
+      while (rest.size() > 0) {
+        auto n = std::min<size_t>(seed * 7 + 1, rest.size());
+        dec.feed(rest.subspan(0, n));
+        rest = rest.subspan(n);
+        for (auto& i : dec.take())
+          a_.emplace_back(std::move(i));
+      }
+      dec.finish();
+
+      if (a_ != a)
+        throw std::runtime_error("Incremental dynamic sequence corrupted");
+    }
+
+    incremental_expand_seq<std::string, varint> short_dec;
+    short_dec.feed(data_const_ref{buf}.subspan(0, buf.size() - 1));
+    check_throws([&] { short_dec.finish(); }, "Truncated sequence not detected");
+  }
+
+  {
+    std::vector<uint32_t> b;
+    for (uint32_t i = 0; i < 1000; ++i)
+      b.push_back(i * 0x01010101);
+    data buf = squash_seq(b.begin(), b.end());
+
+    for (size_t seed = 0; seed < 8; ++seed) {
+      incremental_expand_seq<uint32_t> dec;
+      feed_in_chunks(dec, buf, seed);
+      if (dec.need() != sizeof(uint32_t))
+        throw std::runtime_error("Incorrect static sequence need");
+      dec.finish();
+      if (dec.get() != b)
+        throw std::runtime_error("Incremental static sequence corrupted");
+    }
+  }
+}
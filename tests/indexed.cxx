@@ -0,0 +1,78 @@
+#include "c3/nu/data/collections.hpp"
+
+using namespace c3::nu;
+
+int main() {
+  std::string a = "foobar";
+  uint32_t b = 0x4a;
+  data c = {69, 180};
+  std::string d = "";
+  uint16_t e = 420;
+  std::string f = "wibble";
+
+  data buf = squash_indexed<uint16_t>(a, b, c, d, e, f);
+  if (buf.size() != squashed_indexed_size<uint16_t>(a, b, c, d, e, f) ||
+      buf.size() != 5 * 2 + a.size() + 4 + c.size() + d.size() + 2 + f.size())
+    throw std::runtime_error("squash_indexed has the wrong size");
+
+  squash_view<uint16_t, std::string, uint32_t, data, std::string, uint16_t, std::string_view> view{buf};
+  if (view.size() != 6)
+    throw std::runtime_error("squash_view has the wrong number of fields");
+
+  // In any order, without touching the others
+  if (view.get<5>() != f || view.get<4>() != e || view.get<0>() != a ||
+      view.get<3>() != d || view.get<2>() != c || view.get<1>() != b)
+    throw std::runtime_error("squash_view corrupted");
+
+  auto f_raw = view.raw(5);
+  if (f_raw.data() < buf.data() || f_raw.data() + f_raw.size() != buf.data() + buf.size())
+    throw std::runtime_error("squash_view copied");
+
+  bool threw = false;
+  try { view.raw(6); }
+  catch (std::out_of_range&) { threw = true; }
+  if (!threw)
+    throw std::runtime_error("Out of range field not detected");
+
+  {
+    data bad = buf;
+    // Make field 1 start before field 0
+    bad[0] = 0xff;
+    threw = false;
+    try { squash_view<uint16_t, std::string, uint32_t, data, std::string, uint16_t, std::string> v{bad}; }
+    catch (serialisation_failure&) { threw = true; }
+    if (!threw)
+      throw std::runtime_error("Corrupt offset table not detected");
+  }
+
+  {
+    data bad = buf;
+    // Give the uint32_t field the wrong length
+    bad[3] += 1;
+    threw = false;
+    try { squash_view<uint16_t, std::string, uint32_t, data, std::string, uint16_t, std::string> v{bad}; }
+    catch (serialisation_failure&) { threw = true; }
+    if (!threw)
+      throw std::runtime_error("Wrongly sized static field not detected");
+  }
+
+  {
+    data little = squash_indexed<uint32_t, byte_order::little>(b, a);
+    if (little[0] != 4 || little[1] != 0)
+      throw std::runtime_error("Little-endian offsets incorrect");
+    basic_squash_view<uint32_t, byte_order::little, uint32_t, std::string> v{little};
+    if (v.get<0>() != b || v.get<1>() != a)
+      throw std::runtime_error("Little-endian squash_view corrupted");
+  }
+
+  {
+    std::string big(300, 'x');
+    data out;
+    data_sink sink{out};
+    threw = false;
+    try { squash_indexed_into<uint8_t>(sink, big, a); }
+    catch (serialisation_failure&) { threw = true; }
+    if (!threw)
+      throw std::runtime_error("OffsetType overflow not detected");
+  }
+}
@@ -0,0 +1,107 @@
+#include "c3/nu/bits.hpp"
+#include "c3/nu/data/collections.hpp"
+
+#include <list>
+#include <random>
+
+using namespace c3::nu;
+
+template<typename T>
+void check_round_trip(const std::vector<T>& a) {
+  data buf = squash_packed(a.begin(), a.end());
+  if (expand_packed<T>(buf) != a)
+    throw std::runtime_error("Packed round trip corrupted");
+
+  std::list<T> a_list(a.begin(), a.end());
+  if (squash_packed(a_list.begin(), a_list.end()) != buf)
+    throw std::runtime_error("Packed squash depends on the iterator");
+
+  // Unpacking must stop at the end of its own bits
+  data padded = buf;
+  padded.resize(buf.size() + 32);
+  if (expand_packed<T>(data_const_ref{padded}.subspan(0, buf.size())) != a)
+    throw std::runtime_error("Packed expand depends on what follows the buffer");
+
+  if (expand_packed<T, byte_order::little>(squash_packed<byte_order::little>(a.begin(), a.end())) != a)
+    throw std::runtime_error("Little-endian packed round trip corrupted");
+}
+
+template<typename T>
+void check_random() {
+  std::mt19937_64 rng{sizeof(T)};
+  for (size_t n : { 0, 1, 2, 127, 128, 129, 1000 }) {
+    std::vector<T> a(n);
+    for (auto& i : a)
+      i = static_cast<T>(rng());
+    check_round_trip(a);
+
+    // Every width from 0 to the full size of T
+    for (size_t width = 0; width <= sizeof(T) * CHAR_BIT; ++width) {
+      for (auto& i : a)
+        i = static_cast<T>(width == 0 ? 7 : static_cast<uint64_t>(rng()) >> (64 - width));
+      check_round_trip(a);
+    }
+  }
+}
+
+int main() {
+  check_random<uint8_t>();
+  check_random<int16_t>();
+  check_random<uint32_t>();
+  check_random<int64_t>();
+  check_random<uint64_t>();
+
+  // Sorted timestamps a few units apart should take a few bits each
+  std::vector<uint64_t> timestamps(10000);
+  std::mt19937_64 rng;
+  uint64_t now = 1'600'000'000'000'000'000;
+  for (auto& i : timestamps)
+    i = now += rng() % 16;
+  check_round_trip(timestamps);
+  if (squash_packed(timestamps.begin(), timestamps.end()).size() * 8 > timestamps.size() * sizeof(uint64_t))
+    throw std::runtime_error("Packed timestamps did not shrink");
+
+  // Small steps either way, including across zero and through wrapping
+  std::vector<int32_t> walk(1000);
+  int32_t pos = 0;
+  for (auto& i : walk)
+    i = pos += static_cast<int32_t>(rng() % 7) - 3;
+  check_round_trip(walk);
+  check_round_trip(std::vector<uint8_t>{ 250, 253, 255, 2, 5, 1, 254 });
+  check_round_trip(std::vector<int64_t>{ std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(),
+                                         0, -1, std::numeric_limits<int64_t>::min() });
+
+  // An evenly spaced block needs no bits beyond its header
+  std::vector<uint32_t> even(128);
+  for (size_t i = 0; i < even.size(); ++i)
+    even[i] = static_cast<uint32_t>(1000 + i * 5);
+  auto even_buf = squash_packed(even.begin(), even.end());
+  if (even_buf.size() != 2 + 4 + 1 + 1 || even_buf.back() != 0)
+    throw std::runtime_error("Evenly spaced block was not packed to width 0");
+
+  // The packed bits are laid out as bits_ref would read them
+  std::vector<uint16_t> bits_check = { 0, 3, 1, 6, 2, 9 };
+  auto bits_buf = squash_packed(bits_check.begin(), bits_check.end());
+  // zigzagged deltas are 6, 3, 10, 7, 14, so min 3 and width 4
+  bits_const_ref packed{data_const_ref{bits_buf}.subspan(1 + 2 + 1 + 1)};
+  std::vector<uint64_t> expected = { 3, 0, 7, 4, 11 };
+  for (size_t i = 0; i < expected.size(); ++i)
+    if (packed.get_datum(i * 4, 4).get() != expected[i])
+      throw std::runtime_error("Packed bits are not laid out as bits_ref reads them");
+
+  // Corrupt inputs
+  auto check_throws = [](data_const_ref b) {
+    try { expand_packed<uint32_t>(b); }
+    catch (const std::exception&) { return; }
+    throw std::runtime_error("Corrupt packed sequence was accepted");
+  };
+  auto buf = squash_packed(walk.begin(), walk.end());
+  for (size_t len : { size_t{0}, size_t{1}, size_t{5}, buf.size() / 2, buf.size() - 1 })
+    check_throws(data_const_ref{buf}.subspan(0, static_cast<data_const_ref::index_type>(len)));
+  auto bad_width = buf;
+  bad_width[2 + 4 + 1] = 33;
+  check_throws(bad_width);
+  auto spare = buf;
+  spare.push_back(0);
+  check_throws(spare);
+}
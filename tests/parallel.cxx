@@ -0,0 +1,62 @@
+#include "c3/nu/data/collections.hpp"
+#include "c3/nu/data/helpers.hpp"
+
+using namespace c3::nu;
+
+struct point {
+  int32_t x;
+  int32_t y;
+  uint8_t z;
+
+  bool operator==(const point& other) const { return x == other.x && y == other.y && z == other.z; }
+
+  C3_NU_FIELDS(x, y, z)
+};
+
+int main() {
+  const size_t n = 100000;
+
+  std::vector<uint32_t> a(n);
+  std::vector<point> b(n);
+  std::vector<std::string> c(n);
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = static_cast<uint32_t>(i * 2654435761u);
+    b[i] = { static_cast<int32_t>(i), -static_cast<int32_t>(i), static_cast<uint8_t>(i) };
+    c[i] = std::string(i % 17, static_cast<char>('a' + i % 26));
+  }
+
+  for (size_t n_threads : { 0, 1, 3, 8 }) {
+    data a_buf = squash_seq_par(a.begin(), a.end(), n_threads);
+    if (a_buf != squash_seq(a.begin(), a.end()) || expand_seq_par<uint32_t>(a_buf, n_threads) != a)
+      throw std::runtime_error("Parallel bulk sequence corrupted");
+
+    data b_buf = squash_seq_par(b.begin(), b.end(), n_threads);
+    if (b_buf != squash_seq(b.begin(), b.end()) || expand_seq_par<point>(b_buf, n_threads) != b)
+      throw std::runtime_error("Parallel static sequence corrupted");
+
+    data c_buf = squash_seq_par<varint>(c.begin(), c.end(), n_threads);
+    if (c_buf != squash_seq<varint>(c.begin(), c.end()) ||
+        expand_seq_par<std::string, varint>(c_buf, n_threads) != c)
+      throw std::runtime_error("Parallel dynamic sequence corrupted");
+
+    data little = squash_seq_par<uint16_t, byte_order::little>(c.begin(), c.end(), n_threads);
+    if (expand_seq<std::string, uint16_t, byte_order::little>(little) != c)
+      throw std::runtime_error("Parallel little-endian sequence corrupted");
+  }
+
+  // Small inputs are not worth splitting, but must still work
+  std::vector<uint16_t> d = { 1, 2, 3 };
+  if (expand_seq_par<uint16_t>(squash_seq_par(d.begin(), d.end(), 8), 8) != d)
+    throw std::runtime_error("Small parallel sequence corrupted");
+
+  // Errors on worker threads reach the caller
+  std::vector<std::string> e(n, "x");
+  e[n - 1] = std::string(300, 'y');
+  bool threw = false;
+  try { squash_seq_par<uint8_t>(e.begin(), e.end(), 4); }
+  catch (serialisation_failure&) { threw = true; }
+  if (!threw)
+    throw std::runtime_error("Worker error lost");
+}
+
+#include "c3/nu/data/clean_helpers.hpp"
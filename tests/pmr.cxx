@@ -0,0 +1,77 @@
+#include "c3/nu/data/collections/mixed.hpp"
+#include "c3/nu/data/encoders/base64.hpp"
+#include "c3/nu/data/encoders/json.hpp"
+#include "c3/nu/data/encoders/xml.hpp"
+
+#include <memory_resource>
+
+using namespace c3::nu;
+
+/// Counts what is allocated through it
+class counting_resource : public std::pmr::memory_resource {
+public:
+  size_t n_allocs = 0;
+
+private:
+  std::pmr::memory_resource* _upstream;
+
+  void* do_allocate(size_t bytes, size_t align) override {
+    ++n_allocs;
+    return _upstream->allocate(bytes, align);
+  }
+  void do_deallocate(void* p, size_t bytes, size_t align) override { _upstream->deallocate(p, bytes, align); }
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+  counting_resource(std::pmr::memory_resource* upstream) : _upstream{upstream} {}
+};
+
+int main() {
+  // An arena that cannot fall back to the heap, so everything must fit in the buffer
+  std::array<std::byte, 1 << 16> buf;
+  std::pmr::monotonic_buffer_resource arena{buf.data(), buf.size(), std::pmr::null_memory_resource()};
+  counting_resource counter{&arena};
+
+  std::string str = "Lorem ipsum dolor sit amet";
+  uint32_t num = 42;
+
+  pmr::data squashed = squash<uint16_t>(&counter, str, num, str);
+  if (!std::equal(squashed.begin(), squashed.end(), squash<uint16_t>(str, num, str).begin()) ||
+      squashed.get_allocator().resource() != &counter)
+    throw std::runtime_error("Arena squash corrupted");
+  if (squash(&counter, num, str).size() != squash(num, str).size())
+    throw std::runtime_error("Arena hybrid squash corrupted");
+  auto little = squash<uint16_t, byte_order::little>(&counter, str, num);
+  auto little_ = squash<uint16_t, byte_order::little>(str, num);
+  if (!std::equal(little.begin(), little.end(), little_.begin(), little_.end()))
+    throw std::runtime_error("Arena little-endian squash corrupted");
+
+  pmr::data out{&counter};
+  pmr::data_sink sink{out};
+  serialise_into(str, sink);
+  if (std::string(out.begin(), out.end()) != str)
+    throw std::runtime_error("pmr::data_sink corrupted");
+
+  auto b64 = base64_encode_data(squashed, &counter);
+  if (std::string_view{b64} != base64_encode_data(squashed) || b64.get_allocator().resource() != &counter)
+    throw std::runtime_error("Arena base64 corrupted");
+
+  obj_struct obj;
+  obj["host"] = "web-01";
+  obj["values"] = obj_struct::arr_t{ 1, 2, 3 };
+  obj["nested"]["ok"] = true;
+  auto json = json_encode(obj, &counter);
+  if (std::string_view{json} != json_encode(obj))
+    throw std::runtime_error("Arena json corrupted");
+
+  markup_struct ms{"root", markup_struct::attr, "id", "1", markup_struct::value, "text & more"};
+  auto xml = xml_encode(ms, &counter);
+  if (std::string_view{xml} != xml_encode(ms))
+    throw std::runtime_error("Arena xml corrupted");
+
+  if (counter.n_allocs == 0)
+    throw std::runtime_error("Nothing was allocated from the arena");
+
+  // Dropping everything at once is the point of the arena
+  arena.release();
+}
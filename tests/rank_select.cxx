@@ -0,0 +1,59 @@
+#include "c3/nu/rank_select.hpp"
+
+#include <random>
+
+using namespace c3::nu;
+
+void check(const data& buf, size_t len) {
+  bits_const_ref bits{buf.data(), len};
+  rank_select_bits rs{bits};
+
+  std::vector<size_t> ones, zeros;
+  for (size_t i = 0; i < len; ++i) {
+    if (rs.rank1(i) != ones.size() || rs.rank0(i) != zeros.size())
+      throw std::runtime_error("Wrong rank");
+    (bits.get_bit(i) ? ones : zeros).push_back(i);
+  }
+  if (rs.rank1(len) != ones.size() || rs.count_ones() != ones.size() || rs.count_zeros() != zeros.size())
+    throw std::runtime_error("Wrong total");
+
+  for (size_t k = 0; k < ones.size(); ++k)
+    if (rs.select1(k) != ones[k])
+      throw std::runtime_error("Wrong select1");
+  for (size_t k = 0; k < zeros.size(); ++k)
+    if (rs.select0(k) != zeros[k])
+      throw std::runtime_error("Wrong select0");
+
+  auto throws = [](auto f) {
+    try { f(); }
+    catch (std::out_of_range&) { return true; }
+    return false;
+  };
+  if (!throws([&] { rs.select1(ones.size()); }) || !throws([&] { rs.select0(zeros.size()); }) ||
+      !throws([&] { rs.rank1(len + 1); }))
+    throw std::runtime_error("Out of range query accepted");
+}
+
+int main() {
+  std::mt19937_64 rng{7};
+
+  // Densities from empty to full, so that samples land both far apart and in every block
+  for (unsigned density : { 0, 1, 8, 128, 255, 256 }) {
+    data buf(40000);
+    for (auto& i : buf) {
+      i = 0;
+      for (size_t bit = 0; bit < CHAR_BIT; ++bit)
+        if (rng() % 256 < density)
+          i |= 1 << bit;
+    }
+
+    for (size_t len : { 0, 1, 63, 64, 65, 511, 512, 513, 8 * 8192 + 3, 8 * 40000 })
+      check(buf, len);
+  }
+
+  // The index should stay within a few percent of the bits
+  data buf(1 << 20, 0x55);
+  rank_select_bits rs{bits_const_ref{buf}};
+  if (rs.index_bytes() * 100 > buf.size() * 6)
+    throw std::runtime_error("Index too large");
+}
@@ -0,0 +1,120 @@
+#include "c3/nu/data/record_file.hpp"
+#include "c3/nu/data/collections/mixed.hpp"
+
+#include <cstdio>
+
+using namespace c3::nu;
+
+template<typename Exception, typename F>
+void check_throws(F f, const char* msg) {
+  bool threw = false;
+  try { f(); }
+  catch (Exception&) { threw = true; }
+  if (!threw)
+    throw std::runtime_error(msg);
+}
+
+int main() {
+  const std::string path = "record_file_test.bin";
+  const std::string corrupt_path = "record_file_test_corrupt.bin";
+
+  std::vector<std::string> records;
+  for (size_t i = 0; i < 1000; ++i)
+    records.emplace_back(std::string(i % 37, static_cast<char>('a' + i % 26)) + std::to_string(i));
+
+  {
+    record_file_writer writer{path, 64};
+    for (auto& i : records)
+      writer.append(i);
+    // Records can be anything serialisable
+    writer.append(squash<uint16_t>(std::string{"foo"}, uint32_t{0x4a}));
+    writer.finish();
+  }
+
+  {
+    record_file file{path};
+    if (file.size() != records.size() + 1)
+      throw std::runtime_error("Record file has the wrong size");
+
+    // Random access, borrowing from the mapping
+    for (size_t i : { 999, 0, 500, 63, 64, 65 }) {
+      if (file.get<std::string_view>(i) != records[i] || file.get<std::string>(i) != records[i])
+        throw std::runtime_error("Record corrupted");
+      if (file.record_checked(i).size() != static_cast<data_const_ref::size_type>(records[i].size()))
+        throw std::runtime_error("Checked record corrupted");
+    }
+
+    std::string a;
+    uint32_t b;
+    expand<uint16_t>(file.record(records.size()), a, b);
+    if (a != "foo" || b != 0x4a)
+      throw std::runtime_error("Nested record corrupted");
+
+    auto view = file.records();
+    if (view.size() != file.size())
+      throw std::runtime_error("Record sequence has the wrong size");
+    size_t i = 0;
+    for (auto rec : view) {
+      if (i < records.size() && !std::equal(rec.begin(), rec.end(), records[i].begin(), records[i].end()))
+        throw std::runtime_error("Record sequence corrupted");
+      ++i;
+    }
+
+    file.verify();
+
+    check_throws<std::out_of_range>([&] { file.record(file.size()); }, "Out of range record not detected");
+  }
+
+  {
+    record_file_writer writer{corrupt_path};
+    writer.finish();
+    record_file file{corrupt_path};
+    if (!file.empty())
+      throw std::runtime_error("Empty record file not empty");
+    file.verify();
+  }
+
+  {
+    // An invalid writer must not truncate the file it was pointed at
+    record_file file{path};
+    auto n = file.size();
+    check_throws<std::invalid_argument>([&] { record_file_writer{path, 0}; }, "Zero records per block accepted");
+    if (record_file{path}.size() != n)
+      throw std::runtime_error("Rejected writer truncated the file");
+  }
+
+  {
+    // Flip a byte in the middle of record 500
+    data contents;
+    {
+      std::ifstream in{path, std::ios::binary};
+      contents.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+    }
+    record_file file{path};
+    // The record area starts after the 8 byte header
+    auto offset = static_cast<size_t>(file.record(500).data() - file.records().raw().data()) + 8;
+    contents[offset] ^= 0xff;
+    {
+      std::ofstream out{corrupt_path, std::ios::binary | std::ios::trunc};
+      out.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+    }
+
+    record_file corrupt{corrupt_path};
+    // Unchecked reads do not notice, but checked ones do
+    corrupt.record(500);
+    corrupt.record_checked(0);
+    check_throws<serialisation_failure>([&] { corrupt.record_checked(500); }, "Corrupt record not detected");
+    check_throws<serialisation_failure>([&] { corrupt.verify(); }, "Corrupt file not verified");
+
+    // Truncating the file loses the trailer
+    contents.resize(contents.size() - 1);
+    {
+      std::ofstream out{corrupt_path, std::ios::binary | std::ios::trunc};
+      out.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+    }
+    check_throws<serialisation_failure>([&] { record_file truncated{corrupt_path}; }, "Truncation not detected");
+  }
+
+  std::remove(path.c_str());
+  std::remove(corrupt_path.c_str());
+}
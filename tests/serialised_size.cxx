@@ -0,0 +1,108 @@
+#include "c3/nu/data/collections.hpp"
+#include "c3/nu/data/framing.hpp"
+#include "c3/nu/data/helpers.hpp"
+
+using namespace c3::nu;
+
+class wrapped_str : public serialisable<wrapped_str> {
+public:
+  std::string str;
+
+public:
+  wrapped_str(std::string str) : str{std::move(str)} {}
+
+public:
+  C3_NU_DEFER_SERIALISATION_VAR(wrapped_str, str)
+};
+
+class liar : public serialisable<liar> {
+  friend serialisable<liar>;
+  template<typename U>
+  friend constexpr size_t c3::nu::serialised_size_of(const U&);
+
+private:
+  data _serialise() const override { return { 1, 2, 3 }; }
+  size_t _serialised_size_of() const { return 2; }
+};
+
+// Only provides _serialise, so can only be sized by serialising it
+class counted : public serialisable<counted> {
+  friend serialisable<counted>;
+
+public:
+  static inline size_t n_serialised = 0;
+  std::string str;
+
+public:
+  counted(std::string str) : str{std::move(str)} {}
+
+private:
+  data _serialise() const override {
+    ++n_serialised;
+    return serialise(str);
+  }
+};
+
+void check_once(const char* what, data expected, size_t n_elems, data got) {
+  if (got != expected)
+    throw std::runtime_error(std::string{what} + " corrupted");
+  if (counted::n_serialised != n_elems)
+    throw std::runtime_error(std::string{what} + " serialised an element more than once");
+  counted::n_serialised = 0;
+}
+
+int main() {
+  static_assert(serialised_size_of(uint32_t{}) == 4);
+
+  std::string a = "foobar";
+  uint32_t b = 0x4a;
+  wrapped_str c{"wibble"};
+  data d = {69, 180};
+
+  if (serialised_size_of(a) != a.size() ||
+      serialised_size_of(c) != c.str.size() ||
+      serialised_size_of(d) != d.size() ||
+      serialised_size_of("hi") != 2)
+    throw std::runtime_error("serialised_size_of incorrect");
+
+  data buf = squash<uint16_t>(a, b, c, d);
+  if (buf.size() != squashed_size<uint16_t>(a, b, c, d))
+    throw std::runtime_error("squashed_size incorrect");
+  if (buf.capacity() != buf.size())
+    throw std::runtime_error("squash did not allocate exactly once");
+
+  std::vector<std::string> e = { "foo", "bar", "baz", "quux", "wibble" };
+  data seq = squash_seq<uint16_t>(e.begin(), e.end());
+  if (seq.size() != squashed_seq_size<uint16_t>(e.begin(), e.end()))
+    throw std::runtime_error("squashed_seq_size incorrect");
+  if (seq.capacity() != seq.size())
+    throw std::runtime_error("squash_seq did not allocate exactly once");
+
+  // Elements are only sized up front when that does not mean serialising them
+  static_assert(knows_serialised_size_v<std::string> && knows_serialised_size_v<const char*> &&
+                knows_serialised_size_v<wrapped_str> && knows_serialised_size_v<liar> &&
+                !knows_serialised_size_v<counted>);
+
+  counted f{"counted"};
+  std::vector<counted> fs(3, f);
+  std::vector<std::string> strs(3, f.str);
+
+  check_once("squash", squash<uint16_t>(f.str, b, f.str), 2, squash<uint16_t>(f, b, f));
+  check_once("varint squash", squash<varint>(f.str, f.str), 2, squash<varint>(f, f));
+  check_once("squash_seq", squash_seq<uint16_t>(strs.begin(), strs.end()), 3,
+             squash_seq<uint16_t>(fs.begin(), fs.end()));
+  check_once("squash_indexed", squash_indexed<uint16_t>(f.str, b, f.str), 2, squash_indexed<uint16_t>(f, b, f));
+  check_once("serialise_framed", serialise_framed(f.str), 1, serialise_framed(f));
+
+  gather_sink gather;
+  squash_into<uint16_t>(gather, f, b, f);
+  check_once("Gathered squash", squash<uint16_t>(f.str, b, f.str), 2, gather.flatten());
+
+  bool threw = false;
+  try { squash<uint16_t>(liar{}, b); }
+  catch (serialisation_failure&) { threw = true; }
+  if (!threw)
+    throw std::runtime_error("Incorrect size estimate not detected");
+}
+
+#include "c3/nu/data/clean_helpers.hpp"
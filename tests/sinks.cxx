@@ -0,0 +1,85 @@
+#include "c3/nu/data/collections.hpp"
+#include "c3/nu/data/helpers.hpp"
+
+using namespace c3::nu;
+
+class wrapped_str : public serialisable<wrapped_str> {
+public:
+  std::string str;
+
+public:
+  wrapped_str() = default;
+  wrapped_str(std::string str) : str{std::move(str)} {}
+
+public:
+  C3_NU_DEFER_SERIALISATION_VAR(wrapped_str, str)
+};
+
+int main() {
+  std::string a = "foobar";
+  uint32_t b = 0x4a;
+  wrapped_str c{"wibble"};
+  std::vector<std::string> d = { "foo", "bar", "baz" };
+  std::vector<uint16_t> e = { 420, 69, 180 };
+
+  // Reusing the same buffer should give the same bytes as the allocating versions
+  data buf;
+  {
+    data_sink sink{buf};
+
+    squash_into<uint16_t>(sink, a, b, c);
+    if (buf != squash<uint16_t>(a, b, c))
+      throw std::runtime_error("squash_into corrupted");
+
+    buf.clear();
+    squash_seq_into<uint16_t>(sink, d.begin(), d.end());
+    if (buf != squash_seq<uint16_t>(d.begin(), d.end()))
+      throw std::runtime_error("dynamic squash_seq_into corrupted");
+
+    buf.clear();
+    squash_seq_into(sink, e.begin(), e.end());
+    if (buf != squash_seq(e.begin(), e.end()))
+      throw std::runtime_error("static squash_seq_into corrupted");
+
+    buf.clear();
+    squash_static_into(sink, b, e[0]);
+    if (buf != squash_static(b, e[0]))
+      throw std::runtime_error("squash_static_into corrupted");
+  }
+
+  {
+    auto expected = squash<uint16_t>(a, b, c);
+
+    data fixed(expected.size());
+    span_sink sink{fixed};
+    squash_into<uint16_t>(sink, a, b, c);
+    if (fixed != expected || sink.size() != expected.size())
+      throw std::runtime_error("span_sink corrupted");
+
+    decltype(a) a_;
+    decltype(b) b_;
+    decltype(c) c_;
+    expand<uint16_t>(fixed, a_, b_, c_);
+    if (a != a_ || b != b_ || c.str != c_.str)
+      throw std::runtime_error("span_sink output could not be expanded");
+
+    bool threw = false;
+    try { serialise_into(a, sink); }
+    catch (serialisation_failure&) { threw = true; }
+    if (!threw)
+      throw std::runtime_error("span_sink overran");
+  }
+
+  {
+    data big(0x10000, 0x69);
+    data out;
+    data_sink sink{out};
+    bool threw = false;
+    try { squash_into<uint8_t>(sink, big, b); }
+    catch (serialisation_failure&) { threw = true; }
+    if (!threw)
+      throw std::runtime_error("SizeType overflow not detected");
+  }
+}
+
+#include "c3/nu/data/clean_helpers.hpp"
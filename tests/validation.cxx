@@ -0,0 +1,108 @@
+#include "c3/nu/data/collections.hpp"
+
+#include <random>
+
+using namespace c3::nu;
+
+enum class colour : uint16_t { red, green, blue };
+
+template<typename F>
+void check_throws(F&& f) {
+  try { f(); }
+  catch (const std::exception&) { return; }
+  throw std::runtime_error("Invalid input was accepted");
+}
+
+int main() {
+  // expand_static
+  {
+    uint32_t a = 0xdeadbeef;
+    colour b = colour::blue;
+    static_data<3> c = { 1, 2, 3 };
+    int64_t d = -42;
+    data buf = squash_static(a, b, c, d);
+
+    uint32_t a_;
+    colour b_;
+    static_data<3> c_;
+    int64_t d_;
+    expand_static<validation::validate_once>(buf, a_, b_, c_, d_);
+    if (a_ != a || b_ != b || c_ != c || d_ != d)
+      throw std::runtime_error("Unchecked expand_static corrupted");
+
+    data little = squash_static<byte_order::little>(a, b, c, d);
+    expand_static<byte_order::little, validation::validate_once>(little, a_, b_, c_, d_);
+    if (a_ != a || b_ != b || c_ != c || d_ != d)
+      throw std::runtime_error("Unchecked little-endian expand_static corrupted");
+
+    check_throws([&] { expand_static<validation::validate_once>(data_const_ref{buf}.subspan(1), a_, b_, c_, d_); });
+  }
+
+  // expand_seq
+  {
+    std::mt19937_64 rng;
+    std::vector<uint64_t> ints(1000);
+    std::vector<colour> colours(1000);
+    std::vector<std::string> strs(1000);
+    for (size_t i = 0; i < ints.size(); ++i) {
+      ints[i] = rng();
+      colours[i] = static_cast<colour>(rng() % 3);
+      strs[i] = std::string(rng() % 300, static_cast<char>('a' + i % 26));
+    }
+
+    if (expand_seq<uint64_t, validation::validate_once>(squash_seq(ints.begin(), ints.end())) != ints)
+      throw std::runtime_error("Unchecked expand_seq of ints corrupted");
+
+    data colour_buf = squash_seq<byte_order::little>(colours.begin(), colours.end());
+    if (expand_seq<colour, byte_order::little, validation::validate_once>(colour_buf) != colours)
+      throw std::runtime_error("Unchecked expand_seq of enums corrupted");
+    check_throws([&] { expand_seq<colour, validation::validate_once>(data_const_ref{colour_buf}.subspan(1)); });
+
+    data u16_buf = squash_seq<uint16_t>(strs.begin(), strs.end());
+    data varint_buf = squash_seq<varint>(strs.begin(), strs.end());
+    if (expand_seq<std::string, uint16_t, validation::validate_once>(u16_buf) != strs ||
+        expand_seq<std::string, varint, validation::validate_once>(varint_buf) != strs)
+      throw std::runtime_error("Unchecked expand_seq of strings corrupted");
+
+    for (auto len : { u16_buf.size() - 1, u16_buf.size() / 2, size_t{1} })
+      check_throws([&] {
+        expand_seq<std::string, uint16_t, validation::validate_once>(
+          data_const_ref{u16_buf}.subspan(0, static_cast<data_const_ref::index_type>(len)));
+      });
+    // A truncated prefix at the end
+    auto bad_varint = varint_buf;
+    bad_varint.push_back(0x80);
+    check_throws([&] { expand_seq<std::string, varint, validation::validate_once>(bad_varint); });
+  }
+
+  // expand
+  {
+    std::string a = "Lorem ipsum", c = "dolor sit amet";
+    uint32_t b = 42;
+    data buf = squash<uint16_t>(a, b, c);
+
+    std::string a_, c_;
+    uint32_t b_;
+    expand<uint16_t, validation::validate_once>(buf, a_, b_, c_);
+    if (a_ != a || b_ != b || c_ != c)
+      throw std::runtime_error("Unchecked expand corrupted");
+
+    data little = squash<varint, byte_order::little>(a, b, c);
+    expand<varint, byte_order::little, validation::validate_once>(little, a_, b_, c_);
+    if (a_ != a || b_ != b || c_ != c)
+      throw std::runtime_error("Unchecked little-endian expand corrupted");
+
+    // Hybrid collections have no prefixes at all
+    data hybrid = squash(b, b, c);
+    uint32_t b2_;
+    expand<hybrid_collection, validation::validate_once>(hybrid, b_, b2_, c_);
+    if (b_ != b || b2_ != b || c_ != c)
+      throw std::runtime_error("Unchecked hybrid expand corrupted");
+
+    for (size_t len = 0; len < 2 + a.size() + 4; ++len)
+      check_throws([&] {
+        expand<uint16_t, validation::validate_once>(
+          data_const_ref{buf}.subspan(0, static_cast<data_const_ref::index_type>(len)), a_, b_, c_);
+      });
+  }
+}
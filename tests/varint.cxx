@@ -0,0 +1,95 @@
+#include "c3/nu/data/collections.hpp"
+
+using namespace c3::nu;
+
+void check_varint(uint64_t i) {
+  data buf(varint_len(i));
+  encode_varint(i, buf.data());
+
+  // Exactly sized buffers take the slow path, padded ones the fast path
+  data padded = buf;
+  padded.resize(buf.size() + 8, 0xff);
+
+  for (auto* b : { &buf, &padded }) {
+    data_const_ref ref = *b;
+    if (decode_varint(ref) != i)
+      throw std::runtime_error("Varint corrupted");
+    if (static_cast<size_t>(ref.size()) != b->size() - buf.size())
+      throw std::runtime_error("Varint not consumed");
+  }
+}
+
+template<typename F>
+void check_throws(F f, const char* msg) {
+  bool threw = false;
+  try { f(); }
+  catch (std::exception&) { threw = true; }
+  if (!threw)
+    throw std::runtime_error(msg);
+}
+
+int main() {
+  if (varint_len(0) != 1 || varint_len(127) != 1 || varint_len(128) != 2 ||
+      varint_len(16383) != 2 || varint_len(16384) != 3 || varint_len(UINT64_MAX) != varint_max_len)
+    throw std::runtime_error("varint_len incorrect");
+
+  for (int bits = 0; bits < 64; ++bits) {
+    uint64_t i = uint64_t{1} << bits;
+    check_varint(i - 1);
+    check_varint(i);
+    check_varint(i + 1);
+  }
+  check_varint(UINT64_MAX);
+  check_varint(0x0123456789abcdef);
+
+  {
+    data buf = { 0x80, 0x80, 0x80 };
+    check_throws([&] { data_const_ref b = buf; decode_varint(b); }, "Truncated varint not detected");
+
+    data too_long(12, 0xff);
+    check_throws([&] { data_const_ref b = too_long; decode_varint(b); }, "Overlong varint not detected");
+
+    data too_big(varint_max_len, 0xff);
+    too_big.back() = 0x02;
+    check_throws([&] { data_const_ref b = too_big; decode_varint(b); }, "Varint overflow not detected");
+  }
+
+  std::string a = "foo";
+  uint32_t b = 0x4a;
+  std::string c(300, 'x');
+  std::string d = "bar";
+
+  {
+    data buf = squash<varint>(a, b, c, d);
+    if (buf.size() != squashed_size<varint>(a, b, c, d) ||
+        buf.size() != 1 + a.size() + 4 + 2 + c.size() + d.size())
+      throw std::runtime_error("Varint squash has the wrong size");
+    if (buf.size() >= squash<uint32_t>(a, b, c, d).size())
+      throw std::runtime_error("Varint squash did not shrink");
+
+    std::string a_, c_;
+    std::string_view d_;
+    decltype(b) b_;
+    expand<varint>(buf, a_, b_, c_, d_);
+    if (a_ != a || b_ != b || c_ != c || d_ != d)
+      throw std::runtime_error("Varint expand corrupted");
+  }
+
+  {
+    std::vector<std::string> e = { a, c, "", d };
+    data buf = squash_seq<varint>(e.begin(), e.end());
+    if (buf.size() != squashed_seq_size<varint>(e.begin(), e.end()))
+      throw std::runtime_error("Varint squashed_seq_size incorrect");
+
+    if (expand_seq<std::string, varint>(buf) != e)
+      throw std::runtime_error("Varint expand_seq corrupted");
+
+    seq_view<std::string_view, varint> view{buf};
+    if (view.size() != e.size() || !std::equal(e.begin(), e.end(), view.begin(), view.end()))
+      throw std::runtime_error("Varint seq_view corrupted");
+
+    // A prefix claiming more than is left must not be trusted
+    buf[0] = 0x7f;
+    check_throws([&] { expand_seq<std::string, varint>(buf); }, "Overrunning varint prefix not detected");
+  }
+}